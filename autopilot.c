@@ -0,0 +1,256 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "autopilot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sysexits.h>
+
+#include "work_pool.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* The keys that move at every difficulty, and no key at all first. */
+#define AUTOPILOT_MOVES 6
+/* What one more column in front of the ship is worth, in points. */
+#define AUTOPILOT_ROOM 100
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The copies used to search one first move: beam holds the states kept at
+ * the current depth, children the ones they lead to.
+ */
+typedef struct branch
+{
+  game* beam[AUTOPILOT_BEAM];
+  game* children[AUTOPILOT_BEAM * AUTOPILOT_MOVES];
+  /* How many turns the ship survived, then the best _value() at that depth. */
+  int depth;
+  intmax_t value;
+} branch;
+
+struct autopilot
+{
+  branch branches[AUTOPILOT_MOVES];
+  work_pool* pool;
+  const game* root;
+  atomic_size_t nodes;
+  autopilot_stats stats;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// file-scope variables
+////////////////////////////////////////////////////////////////////////////////
+
+static const int moves[AUTOPILOT_MOVES] = { 0, 'k', 'j', 'l', 'h', ' ', };
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static void _search(size_t index, void* arg);
+static void _play(game* g, const game* from, int key);
+static inline intmax_t _value(const game* g);
+static bool _seen(game* const* games, size_t count, uint64_t hash);
+static inline double _seconds(struct timespec t0, struct timespec t1);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+/* The copies and the threads are made once here, then only reused. */
+autopilot* autopilot_new(const game* const g, const size_t threads)
+{
+  autopilot* const a = malloc(sizeof *a);
+  if (!a)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  for (size_t m = 0; m < AUTOPILOT_MOVES; ++m)
+  {
+    branch* const b = a->branches + m;
+    for (size_t i = 0; i < AUTOPILOT_BEAM; ++i)
+      b->beam[i] = game_clone(g);
+    for (size_t i = 0; i < AUTOPILOT_BEAM * AUTOPILOT_MOVES; ++i)
+      b->children[i] = game_clone(g);
+  }
+  a->pool = work_pool_new(threads < AUTOPILOT_MOVES ? threads : AUTOPILOT_MOVES);
+  a->root = NULL;
+  atomic_init(&a->nodes, 0);
+  a->stats = (autopilot_stats) { .searches = 0, .nodes = 0, .seconds = 0.0, };
+
+  return a;
+}
+
+void autopilot_destroy(autopilot* const a)
+{
+  if (!a)
+    return;
+
+  for (size_t m = 0; m < AUTOPILOT_MOVES; ++m)
+  {
+    branch* const b = a->branches + m;
+    for (size_t i = 0; i < AUTOPILOT_BEAM; ++i)
+      game_destroy(b->beam[i]);
+    for (size_t i = 0; i < AUTOPILOT_BEAM * AUTOPILOT_MOVES; ++i)
+      game_destroy(b->children[i]);
+  }
+  work_pool_destroy(a->pool);
+  free(a);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+autopilot_stats autopilot_get_stats(const autopilot* const a)
+{
+  return a->stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The first move that keeps the ship alive the longest, then the one with
+ * the best _value(); ties go to the earliest of moves[], so the result doesn't
+ * depend on the threads.
+ */
+int autopilot_next_key(autopilot* const a, const game* const g)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  a->root = g;
+  atomic_store(&a->nodes, 0);
+  work_pool_run(a->pool, AUTOPILOT_MOVES, _search, a);
+
+  size_t best = 0;
+  for (size_t m = 1; m < AUTOPILOT_MOVES; ++m)
+  {
+    const branch* const b = a->branches + m;
+    const branch* const c = a->branches + best;
+    if (b->depth > c->depth || (b->depth == c->depth && b->value > c->value))
+      best = m;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  ++a->stats.searches;
+  a->stats.nodes += atomic_load(&a->nodes);
+  a->stats.seconds += _seconds(start, end);
+  return moves[best];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Beam search below the first move index. */
+void _search(const size_t index, void* const arg)
+{
+  autopilot* const a = arg;
+  branch* const b = a->branches + index;
+  game** beam = b->beam;
+  game** children = b->children;
+
+  _play(beam[0], a->root, moves[index]);
+  size_t nodes = 1;
+  size_t kept = game_ship_is_alive(beam[0]);
+  b->depth = (int) kept;
+  b->value = _value(beam[0]);
+
+  for (int depth = 1; kept && depth < AUTOPILOT_DEPTH; ++depth)
+  {
+    /* Expand, dropping the dead and the states reached twice. */
+    size_t count = 0;
+    for (size_t i = 0; i < kept; ++i)
+      for (size_t m = 0; m < AUTOPILOT_MOVES; ++m)
+      {
+        game* const child = children[count];
+        _play(child, beam[i], moves[m]);
+        ++nodes;
+        if (game_ship_is_alive(child)
+            && !_seen(children, count, game_get_hash(child)))
+          ++count;
+      }
+    if (!count)
+      break;
+
+    /* Keep the best ones: a partial selection sort is enough for a beam. */
+    kept = count < AUTOPILOT_BEAM ? count : AUTOPILOT_BEAM;
+    for (size_t i = 0; i < kept; ++i)
+    {
+      size_t top = i;
+      for (size_t j = i + 1; j < count; ++j)
+        if (_value(children[j]) > _value(children[top]))
+          top = j;
+      game* const swap = children[i];
+      children[i] = children[top];
+      children[top] = swap;
+      /* The copy it replaces in the beam goes back to the children. */
+      game* const old = beam[i];
+      beam[i] = children[i];
+      children[i] = old;
+    }
+
+    b->depth = depth + 1;
+    b->value = _value(beam[0]);
+  }
+
+  atomic_fetch_add_explicit(&a->nodes, nodes, memory_order_relaxed);
+}
+
+/* from played one more turn after key, into g. */
+void _play(game* const g, const game* const from, const int key)
+{
+  game_restore(g, from);
+  if (key)
+    game_process_input(g, key);
+  game_compute_turn(g);
+}
+
+/*
+ * The score, plus some for the room ahead of the ship: stuck against the left
+ * edge, it has nowhere to go when the walls come.
+ */
+intmax_t _value(const game* const g)
+{
+  return game_get_score(g) + AUTOPILOT_ROOM * game_get_ship_position(g).x;
+}
+
+bool _seen(game* const* const games, const size_t count, const uint64_t hash)
+{
+  for (size_t i = 0; i < count; ++i)
+    if (game_get_hash(games[i]) == hash)
+      return true;
+  return false;
+}
+
+double _seconds(const struct timespec t0, const struct timespec t1)
+{
+  return (double) (t1.tv_sec - t0.tv_sec) + (double) (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
@@ -0,0 +1,73 @@
+#ifndef _AUTOPILOT_H_
+#define _AUTOPILOT_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+#include "game.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* Turns looked ahead, and states kept at each of them. */
+#ifndef AUTOPILOT_DEPTH
+  #define AUTOPILOT_DEPTH 12
+#endif
+#ifndef AUTOPILOT_BEAM
+  #define AUTOPILOT_BEAM 6
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Picks the key to play before each turn with a beam search on copies of the
+ * game: every first move is searched on its own thread, AUTOPILOT_DEPTH turns
+ * deep, keeping the AUTOPILOT_BEAM best states of each turn.
+ */
+typedef struct autopilot autopilot;
+
+/* Since autopilot_new(): a node is one copy played for one turn. */
+typedef struct autopilot_stats
+{
+  size_t searches;
+  size_t nodes;
+  double seconds;
+} autopilot_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+autopilot* autopilot_new(const game* g, size_t threads);
+void autopilot_destroy(autopilot* a);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+autopilot_stats autopilot_get_stats(const autopilot* a);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+int autopilot_next_key(autopilot* a, const game* g);
+
+#endif
@@ -0,0 +1,293 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "bullet_array.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "column.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * x holds the abscissas minus offset, so moving every bullet only changes
+ * offset. The bitmap is a ring indexed the same way: the column of a stored
+ * abscissa never changes and only the one wrapping around is fixed up.
+ */
+struct bullet_array
+{
+  int* x;
+  int* y;
+  bool* alive;
+  size_t count;
+  size_t capacity;
+  int offset;
+  int width;
+  int height;
+  size_t words;
+  uint64_t* occupied;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t _round(size_t size);
+static inline bool _inside(const bullet_array* b, point p);
+static inline uint64_t* _word(const bullet_array* b, int x, int y);
+static inline void _set(bullet_array* b, point p, bool value);
+static void _enter(bullet_array* b, int x);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+/* Bytes of memory bullet_array_init() needs. */
+size_t bullet_array_footprint(
+    const size_t capacity, const int width, const int height)
+{
+  const size_t bitmap = sizeof (uint64_t) * column_words(height) * (size_t) width;
+  return sizeof (bullet_array) + bitmap + 2 * _round(sizeof (int) * capacity)
+      + _round(sizeof (bool) * capacity);
+}
+
+/*
+ * Build the array in memory, bullet_array_footprint() bytes aligned for
+ * uint64_t. It never grows: at most capacity bullets fly at once.
+ */
+bullet_array* bullet_array_init(
+    void* const memory, const size_t capacity, const int width, const int height)
+{
+  bullet_array* const b = memory;
+  b->count = 0;
+  b->capacity = capacity;
+  b->offset = 0;
+  b->width = width;
+  b->height = height;
+  b->words = column_words(height);
+  bullet_array_rebase(b);
+  memset(b->occupied, 0, sizeof *b->occupied * b->words * (size_t) width);
+  return b;
+}
+
+/* Point the arrays of b, maybe just copied elsewhere, right after it. */
+void bullet_array_rebase(bullet_array* const b)
+{
+  b->occupied = (uint64_t*) (b + 1);
+  b->x = (int*) (b->occupied + b->words * (size_t) b->width);
+  b->y = (int*) ((char*) b->x + _round(sizeof *b->x * b->capacity));
+  b->alive = (bool*) ((char*) b->y + _round(sizeof *b->y * b->capacity));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+size_t bullet_array_get_size(const bullet_array* const b)
+{
+  return b->count;
+}
+
+point bullet_array_get_point(const bullet_array* const b, const size_t i)
+{
+  return point_xy(b->x[i] + b->offset, b->y[i]);
+}
+
+bool bullet_array_is_alive(const bullet_array* const b, const size_t i)
+{
+  return b->alive[i];
+}
+
+bool bullet_array_contains(const bullet_array* const b, const point p)
+{
+  if (_inside(b, p))
+    return *_word(b, p.x, p.y) >> (p.y % COLUMN_WORD_BITS) & 1;
+
+  /* Bullets that left the map stay around until the next prune. */
+  for (size_t i = 0; i < b->count; ++i)
+    if (b->alive[i] && point_equals(bullet_array_get_point(b, i), p))
+      return true;
+  return false;
+}
+
+/* The living bullets of the w-th word of column x, one bit each. */
+uint64_t bullet_array_occupied(const bullet_array* const b, const int x, const size_t w)
+{
+  if (x < 0 || x >= b->width)
+    return 0;
+  return *_word(b, x, (int) (w * COLUMN_WORD_BITS));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void bullet_array_push(bullet_array* const b, const point p)
+{
+  if (b->count == b->capacity)
+  {
+    fprintf(stderr, "bullet_array_push: full (%zu bullets).\n", b->capacity);
+    exit(EX_SOFTWARE);
+  }
+
+  /* New bullets appear next to the ship, usually behind the others. */
+  const int x = p.x - b->offset;
+  size_t i = b->count;
+  for (; i > 0 && b->x[i - 1] < x; --i)
+  {
+    b->x[i] = b->x[i - 1];
+    b->y[i] = b->y[i - 1];
+    b->alive[i] = b->alive[i - 1];
+  }
+  b->x[i] = x;
+  b->y[i] = p.y;
+  b->alive[i] = true;
+  ++b->count;
+  _set(b, p, true);
+}
+
+void bullet_array_kill(bullet_array* const b, const size_t i)
+{
+  if (b->alive[i])
+    _set(b, bullet_array_get_point(b, i), false);
+  b->alive[i] = false;
+}
+
+/* Bullets are sorted by x: binary search the column, then look for y. */
+void bullet_array_kill_at(bullet_array* const b, const point p)
+{
+  const int x = p.x - b->offset;
+  size_t low = 0;
+  size_t high = b->count;
+  while (low < high)
+  {
+    const size_t middle = low + (high - low) / 2;
+    if (b->x[middle] > x)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  for (size_t i = low; i < b->count && b->x[i] == x; ++i)
+    if (b->alive[i] && b->y[i] == p.y)
+    {
+      bullet_array_kill(b, i);
+      return;
+    }
+}
+
+void bullet_array_shift(bullet_array* const b, const int dx)
+{
+  for (int i = 0; i < dx; ++i)
+  {
+    ++b->offset;
+    _enter(b, 0);
+  }
+  for (int i = 0; i > dx; --i)
+  {
+    --b->offset;
+    _enter(b, b->width - 1);
+  }
+}
+
+/*
+ * Remove the dead bullets and the ones outside of the rectangle in one sweep
+ * that slides the others down over them, in order. Swapping the last bullet
+ * into each hole would be cheaper but would break the order by x.
+ */
+void bullet_array_prune(
+    bullet_array* const b, const point up_left, const point bottom_right)
+{
+  size_t kept = 0;
+  for (size_t i = 0; i < b->count; ++i)
+  {
+    const point p = bullet_array_get_point(b, i);
+    if (!b->alive[i])
+      continue;
+    if (!point_is_in_rectangle(p, up_left, bottom_right))
+    {
+      _set(b, p, false);
+      continue;
+    }
+
+    b->x[kept] = b->x[i];
+    b->y[kept] = b->y[i];
+    b->alive[kept] = true;
+    ++kept;
+  }
+  b->count = kept;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Keep every array aligned for the bitmap words. */
+size_t _round(const size_t size)
+{
+  const size_t word = sizeof (uint64_t);
+  return (size + word - 1) / word * word;
+}
+
+bool _inside(const bullet_array* const b, const point p)
+{
+  return p.x >= 0 && p.x < b->width && p.y >= 0 && p.y < b->height;
+}
+
+/* Word of the bitmap holding the cell (x, y) of the map. */
+uint64_t* _word(const bullet_array* const b, const int x, const int y)
+{
+  const int slot = ((x - b->offset) % b->width + b->width) % b->width;
+  return b->occupied + (size_t) slot * b->words + (size_t) y / COLUMN_WORD_BITS;
+}
+
+void _set(bullet_array* const b, const point p, const bool value)
+{
+  if (!_inside(b, p))
+    return;
+  const uint64_t bit = UINT64_C(1) << (p.y % COLUMN_WORD_BITS);
+  uint64_t* const word = _word(b, p.x, p.y);
+  *word = value ? *word | bit : *word & ~bit;
+}
+
+/*
+ * After a shift, column x of the bitmap still holds the bullets that just
+ * left the map on the other side: replace them with the ones coming in,
+ * found at the end of the array for x = 0 or at its start otherwise.
+ */
+void _enter(bullet_array* const b, const int x)
+{
+  for (size_t w = 0; w < b->words; ++w)
+    *_word(b, x, (int) (w * COLUMN_WORD_BITS)) = 0;
+
+  const int stored = x - b->offset;
+  if (x == 0)
+  {
+    for (size_t i = b->count; i > 0 && b->x[i - 1] <= stored; --i)
+      if (b->x[i - 1] == stored && b->alive[i - 1])
+        _set(b, point_xy(x, b->y[i - 1]), true);
+  }
+  else
+  {
+    for (size_t i = 0; i < b->count && b->x[i] >= stored; ++i)
+      if (b->x[i] == stored && b->alive[i])
+        _set(b, point_xy(x, b->y[i]), true);
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef _BULLET_ARRAY_H_
+#define _BULLET_ARRAY_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "point.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Bullets in flight, stored as parallel arrays and sorted by decreasing x.
+ * They all move together, so only bullet_array_push() has to keep the order.
+ *
+ * Killed bullets stay until the next bullet_array_prune(), so that indices
+ * are stable while iterating. Pruning compacts the array in place and keeps
+ * the order.
+ *
+ * The living bullets inside the map are also kept in an occupancy bitmap,
+ * one bitboard per column like the terrain, to answer "is there a bullet
+ * here?" in constant time and to test whole columns at once.
+ *
+ * Everything lives in the memory given to bullet_array_init(), so an array
+ * moves with one memcpy() and bullet_array_rebase().
+ */
+typedef struct bullet_array bullet_array;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+size_t bullet_array_footprint(size_t capacity, int width, int height);
+bullet_array* bullet_array_init(void* memory, size_t capacity, int width, int height);
+void bullet_array_rebase(bullet_array* b);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+size_t bullet_array_get_size(const bullet_array* b);
+point bullet_array_get_point(const bullet_array* b, size_t i);
+bool bullet_array_is_alive(const bullet_array* b, size_t i);
+bool bullet_array_contains(const bullet_array* b, point p);
+uint64_t bullet_array_occupied(const bullet_array* b, int x, size_t w);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void bullet_array_push(bullet_array* b, point p);
+void bullet_array_kill(bullet_array* b, size_t i);
+void bullet_array_kill_at(bullet_array* b, point p);
+void bullet_array_shift(bullet_array* b, int dx);
+void bullet_array_prune(bullet_array* b, point up_left, point bottom_right);
+
+#endif
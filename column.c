@@ -14,6 +14,7 @@
  *  0. You just DO WHAT THE FUCK YOU WANT TO.
  */
 #include "column.h"
+#include "prng.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,6 +22,21 @@
 #include <sysexits.h>
 
 /* If you need other headers, include them here: */
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+#ifdef COLUMN_CHECK_FALL
+  #include <string.h>
+#endif
+
+/*
+ * Build with -DCOLUMN_CHECK_FALL for a program that checks the SIMD lanes of
+ * column_fall_many() against column_fall() on views of the same random
+ * columns, see make check-fall. Lanes outside the dirty set must have
+ * settled: the SIMD paths compute whole groups of lanes.
+ */
 
 ////////////////////////////////////////////////////////////////////////////////
 // types
@@ -29,11 +45,21 @@
 /*
 struct column
 {
-  cell* cells;
+  uint64_t* words;
   int height;
+  size_t stride;
 };
 */
 
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t* _word(const column* c, size_t plane, size_t w);
+static inline uint64_t _valid_bits(const column* c, size_t w);
+static bool _fall_words(column* c, size_t words);
+static inline bool _fall_lane(uint64_t* words, size_t stride, uint64_t valid);
+
 ////////////////////////////////////////////////////////////////////////////////
 // init./destroy etc.
 ////////////////////////////////////////////////////////////////////////////////
@@ -46,17 +72,18 @@ column* column_new(const int height, const int low, const int high)
     perror("malloc");
     exit(EX_OSERR);
   }
-  cell* const cells = malloc(sizeof *cells * (size_t) height);
-  if (!cells)
+  const size_t words = column_words(height);
+  uint64_t* const planes = malloc(sizeof *planes * COLUMN_PLANES * words);
+  if (!planes)
   {
     perror("malloc");
     exit(EX_OSERR);
   }
 
-  for (int i = 0; i < height; ++i)
-      cells[i] = i > high || i < low ? CELL_WALL : CELL_EMPTY;
-  c->cells = cells;
+  c->words = planes;
   c->height = height;
+  c->stride = 1;
+  column_reset(c, low, high);
 
   return c;
 }
@@ -66,18 +93,81 @@ void column_destroy(column* const c)
   if (!c)
     return;
 
-  if (c->cells)
-    free(c->cells);
+  if (c->words)
+    free(c->words);
   free(c);
 }
 
+size_t column_words(const int height)
+{
+  return ((size_t) height + COLUMN_WORD_BITS - 1) / COLUMN_WORD_BITS;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // getters
 ////////////////////////////////////////////////////////////////////////////////
 
 cell column_get_cell(const column* const c, const size_t i)
 {
-  return c && c->cells && i < (size_t) c->height ? c->cells[i] : CELL_EMPTY;
+  if (!c || !c->words || i >= (size_t) c->height)
+    return CELL_EMPTY;
+
+  const size_t w = i / COLUMN_WORD_BITS;
+  const unsigned b = (unsigned) (i % COLUMN_WORD_BITS);
+  if (*_word(c, COLUMN_WALL_PLANE, w) >> b & 1)
+    return CELL_WALL;
+
+  unsigned value = 0;
+  for (size_t p = 1; p < COLUMN_PLANES; ++p)
+    value |= (unsigned) (*_word(c, p, w) >> b & 1) << (p - 1);
+  return (cell) value;
+}
+
+bool column_is_wall(const column* const c, const size_t i)
+{
+  if (!c || !c->words || i >= (size_t) c->height)
+    return false;
+
+  const size_t w = i / COLUMN_WORD_BITS;
+  const unsigned b = (unsigned) (i % COLUMN_WORD_BITS);
+  return *_word(c, COLUMN_WALL_PLANE, w) >> b & 1;
+}
+
+/* The cells of the w-th word that are not CELL_EMPTY, one bit each. */
+uint64_t column_occupied(const column* const c, const size_t w)
+{
+  uint64_t occupied = 0;
+  for (size_t p = 0; p < COLUMN_PLANES; ++p)
+    occupied |= *_word(c, p, w);
+  return occupied;
+}
+
+/* The walls of the w-th word, one bit each. */
+uint64_t column_walls(const column* const c, const size_t w)
+{
+  return *_word(c, COLUMN_WALL_PLANE, w);
+}
+
+/*
+ * Hash of the words of a column: the XOR of column_hash_word() over all w.
+ * A cell change only touches word i / COLUMN_WORD_BITS of each plane, so the
+ * hash can be updated with that word alone. key tells the columns apart.
+ */
+uint64_t column_hash(const column* const c, const uint64_t key)
+{
+  uint64_t hash = 0;
+  for (size_t w = 0; w < column_words(c->height); ++w)
+    hash ^= column_hash_word(c, key, w);
+  return hash;
+}
+
+uint64_t column_hash_word(const column* const c, const uint64_t key, const size_t w)
+{
+  const size_t words = column_words(c->height);
+  uint64_t hash = 0;
+  for (size_t p = 0; p < COLUMN_PLANES; ++p)
+    hash ^= prng_mix(prng_mix(key + p * words + w) ^ *_word(c, p, w));
+  return hash;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -86,37 +176,389 @@ cell column_get_cell(const column* const c, const size_t i)
 
 void column_set_cell(column* const c, const size_t i, const cell x)
 {
-  if (c)
-    c->cells[i] = x;
-}
-
-void column_fall(column* const c)
-{
-	int high;
-	int low;
-	for (int i = 0; i < c->height; ++i)
-	{ 
-		if (c->cells[i] == CELL_EMPTY)
-		{
-			high = i;
-			break;
-		}
-	}
-
-	for (int j = c->height; j >0; j--)
-	{
-		if (c->cells[j] == CELL_EMPTY)
-		{
-			low = j;
-			break;
-		}
-	}
-	for (int t = low; t >high; t--)
-	{
-		if (c->cells[t-1] == CELL_WALL)
-		c->cells[t] = c->cells[t - 1];
-	}
-
-	
-  /* Write the code for this function. ! */
+  if (!c || !c->words || i >= (size_t) c->height)
+    return;
+
+  const size_t w = i / COLUMN_WORD_BITS;
+  const uint64_t bit = UINT64_C(1) << (i % COLUMN_WORD_BITS);
+  /* Walls only live in the wall plane, other cells in the overlay. */
+  const unsigned value = x == CELL_WALL ? 0 : (unsigned) x;
+  uint64_t* const wall = _word(c, COLUMN_WALL_PLANE, w);
+  *wall = x == CELL_WALL ? *wall | bit : *wall & ~bit;
+  for (size_t p = 1; p < COLUMN_PLANES; ++p)
+  {
+    uint64_t* const overlay = _word(c, p, w);
+    *overlay = value >> (p - 1) & 1 ? *overlay | bit : *overlay & ~bit;
+  }
+}
+
+/*
+ * Overwrite a column in place with walls everywhere but from low to high,
+ * without touching the heap: this is how the terrain recycles its slots.
+ */
+void column_reset(column* const c, const int low, const int high)
+{
+  const size_t words = column_words(c->height);
+  for (size_t w = 0; w < words; ++w)
+  {
+    const long base = (long) (w * COLUMN_WORD_BITS);
+    const long from = low - base;
+    const long to = high - base;
+    uint64_t open = 0;
+    if (to >= 0 && from < COLUMN_WORD_BITS && from <= to)
+    {
+      open = UINT64_MAX;
+      if (from > 0)
+        open &= UINT64_MAX << from;
+      if (to < COLUMN_WORD_BITS - 1)
+        open &= UINT64_MAX >> (COLUMN_WORD_BITS - 1 - to);
+    }
+    *_word(c, COLUMN_WALL_PLANE, w) = ~open & _valid_bits(c, w);
+    for (size_t p = 1; p < COLUMN_PLANES; ++p)
+      *_word(c, p, w) = 0;
+  }
+}
+
+/*
+ * Between the first and the last empty cells, every cell lying right under a
+ * wall becomes a wall. On bitboards this is new = walls | (walls << 1) & range
+ * where range holds the cells after the first empty one, up to the last one.
+ *
+ * Returns false when nothing moved, i.e. the column has settled.
+ */
+bool column_fall(column* const c)
+{
+  const size_t words = column_words(c->height);
+  if (words != 1)
+    return _fall_words(c, words);
+
+  uint64_t* const wall = _word(c, COLUMN_WALL_PLANE, 0);
+  uint64_t taken = *wall;
+  for (size_t p = 1; p < COLUMN_PLANES; ++p)
+    taken |= *_word(c, p, 0);
+  const uint64_t empty = ~taken & _valid_bits(c, 0);
+  if (!empty)
+    return false;
+
+  const unsigned high = (unsigned) __builtin_ctzll(empty);
+  const unsigned low = COLUMN_WORD_BITS - 1 - (unsigned) __builtin_clzll(empty);
+  /* Bits high + 1 to low, both included. */
+  const uint64_t range =
+      (UINT64_MAX >> (COLUMN_WORD_BITS - 1 - low)) & (UINT64_MAX << high << 1);
+  const uint64_t fallen = *wall << 1 & range & ~*wall;
+  if (!fallen)
+    return false;
+
+  *wall |= fallen;
+  for (size_t p = 1; p < COLUMN_PLANES; ++p)
+    *_word(c, p, 0) &= ~fallen;
+  return true;
+}
+
+/*
+ * column_fall() for count adjacent single-word columns: plane p of the k-th
+ * column is words[p * stride + k], which is how a row-major terrain stores
+ * them. The lanes are independent, so they go through SIMD registers (AVX2 or
+ * SSE2 when available) using only shifts, ands and ors:
+ * - first empty cell: lowest = empty & -empty,
+ * - cells after it: -(lowest << 1),
+ * - cells up to the last empty one: empty smeared towards bit 0.
+ *
+ * Only the columns whose bit is set in the dirty bitset are needed: words of
+ * the set without any dirty column are skipped at once, so are groups of
+ * lanes, and the columns that settled are removed from the set. Returns the
+ * number of dirty columns processed.
+ */
+size_t column_fall_many(
+    uint64_t* const words, const size_t count, const size_t stride,
+    const int height, uint64_t* const dirty)
+{
+  const uint64_t valid = height >= COLUMN_WORD_BITS
+      ? UINT64_MAX : (UINT64_C(1) << height) - 1;
+  size_t processed = 0;
+  size_t k = 0;
+
+#if defined(__AVX2__)
+  const __m256i all = _mm256_set1_epi64x((long long) valid);
+  const __m256i zero = _mm256_setzero_si256();
+  for (; k + 4 <= count; k += 4)
+  {
+    if (!(k % COLUMN_WORD_BITS) && !dirty[k / COLUMN_WORD_BITS])
+    {
+      k += COLUMN_WORD_BITS - 4;
+      continue;
+    }
+    uint64_t* const group = dirty + k / COLUMN_WORD_BITS;
+    const unsigned shift = (unsigned) (k % COLUMN_WORD_BITS);
+    if (!(*group >> shift & 0xF))
+      continue;
+    processed += (size_t) __builtin_popcountll(*group >> shift & 0xF);
+
+    __m256i* const pw = (__m256i*) (words + k);
+    __m256i* const p1 = (__m256i*) (words + stride + k);
+    __m256i* const p2 = (__m256i*) (words + 2 * stride + k);
+    __m256i* const p3 = (__m256i*) (words + 3 * stride + k);
+    const __m256i wall = _mm256_loadu_si256(pw);
+    const __m256i o1 = _mm256_loadu_si256(p1);
+    const __m256i o2 = _mm256_loadu_si256(p2);
+    const __m256i o3 = _mm256_loadu_si256(p3);
+    const __m256i taken =
+        _mm256_or_si256(_mm256_or_si256(wall, o1), _mm256_or_si256(o2, o3));
+    const __m256i empty = _mm256_andnot_si256(taken, all);
+    const __m256i lowest = _mm256_and_si256(empty, _mm256_sub_epi64(zero, empty));
+    const __m256i after = _mm256_sub_epi64(zero, _mm256_slli_epi64(lowest, 1));
+    __m256i before = empty;
+    before = _mm256_or_si256(before, _mm256_srli_epi64(before, 1));
+    before = _mm256_or_si256(before, _mm256_srli_epi64(before, 2));
+    before = _mm256_or_si256(before, _mm256_srli_epi64(before, 4));
+    before = _mm256_or_si256(before, _mm256_srli_epi64(before, 8));
+    before = _mm256_or_si256(before, _mm256_srli_epi64(before, 16));
+    before = _mm256_or_si256(before, _mm256_srli_epi64(before, 32));
+    const __m256i range = _mm256_and_si256(before, after);
+    const __m256i fallen = _mm256_andnot_si256(
+        wall, _mm256_and_si256(_mm256_slli_epi64(wall, 1), range));
+    _mm256_storeu_si256(pw, _mm256_or_si256(wall, fallen));
+    _mm256_storeu_si256(p1, _mm256_andnot_si256(fallen, o1));
+    _mm256_storeu_si256(p2, _mm256_andnot_si256(fallen, o2));
+    _mm256_storeu_si256(p3, _mm256_andnot_si256(fallen, o3));
+
+    const int settled = _mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpeq_epi64(fallen, zero)));
+    *group &= ~((uint64_t) settled << shift);
+  }
+#elif defined(__SSE2__)
+  const __m128i all = _mm_set1_epi64x((long long) valid);
+  const __m128i zero = _mm_setzero_si128();
+  for (; k + 2 <= count; k += 2)
+  {
+    if (!(k % COLUMN_WORD_BITS) && !dirty[k / COLUMN_WORD_BITS])
+    {
+      k += COLUMN_WORD_BITS - 2;
+      continue;
+    }
+    uint64_t* const group = dirty + k / COLUMN_WORD_BITS;
+    const unsigned shift = (unsigned) (k % COLUMN_WORD_BITS);
+    if (!(*group >> shift & 0x3))
+      continue;
+    processed += (size_t) __builtin_popcountll(*group >> shift & 0x3);
+
+    __m128i* const pw = (__m128i*) (words + k);
+    __m128i* const p1 = (__m128i*) (words + stride + k);
+    __m128i* const p2 = (__m128i*) (words + 2 * stride + k);
+    __m128i* const p3 = (__m128i*) (words + 3 * stride + k);
+    const __m128i wall = _mm_loadu_si128(pw);
+    const __m128i o1 = _mm_loadu_si128(p1);
+    const __m128i o2 = _mm_loadu_si128(p2);
+    const __m128i o3 = _mm_loadu_si128(p3);
+    const __m128i taken = _mm_or_si128(_mm_or_si128(wall, o1), _mm_or_si128(o2, o3));
+    const __m128i empty = _mm_andnot_si128(taken, all);
+    const __m128i lowest = _mm_and_si128(empty, _mm_sub_epi64(zero, empty));
+    const __m128i after = _mm_sub_epi64(zero, _mm_slli_epi64(lowest, 1));
+    __m128i before = empty;
+    before = _mm_or_si128(before, _mm_srli_epi64(before, 1));
+    before = _mm_or_si128(before, _mm_srli_epi64(before, 2));
+    before = _mm_or_si128(before, _mm_srli_epi64(before, 4));
+    before = _mm_or_si128(before, _mm_srli_epi64(before, 8));
+    before = _mm_or_si128(before, _mm_srli_epi64(before, 16));
+    before = _mm_or_si128(before, _mm_srli_epi64(before, 32));
+    const __m128i range = _mm_and_si128(before, after);
+    const __m128i fallen = _mm_andnot_si128(
+        wall, _mm_and_si128(_mm_slli_epi64(wall, 1), range));
+    _mm_storeu_si128(pw, _mm_or_si128(wall, fallen));
+    _mm_storeu_si128(p1, _mm_andnot_si128(fallen, o1));
+    _mm_storeu_si128(p2, _mm_andnot_si128(fallen, o2));
+    _mm_storeu_si128(p3, _mm_andnot_si128(fallen, o3));
+
+    /* No 64-bit compare in SSE2: a lane is zero when both halves are. */
+    const int zeros = _mm_movemask_epi8(_mm_cmpeq_epi32(fallen, zero));
+    const uint64_t settled =
+        ((zeros & 0xFF) == 0xFF ? 1u : 0u) | ((zeros >> 8) == 0xFF ? 2u : 0u);
+    *group &= ~(settled << shift);
+  }
+#endif
+
+  for (; k < count; ++k)
+  {
+    if (!(k % COLUMN_WORD_BITS) && !dirty[k / COLUMN_WORD_BITS])
+    {
+      k += COLUMN_WORD_BITS - 1;
+      continue;
+    }
+    uint64_t* const group = dirty + k / COLUMN_WORD_BITS;
+    const uint64_t bit = UINT64_C(1) << (k % COLUMN_WORD_BITS);
+    if (!(*group & bit))
+      continue;
+    ++processed;
+    if (!_fall_lane(words + k, stride, valid))
+      *group &= ~bit;
+  }
+
+  return processed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t* _word(const column* const c, const size_t plane, const size_t w)
+{
+  const size_t words = column_words(c->height);
+  return c->words + (plane * words + w) * c->stride;
+}
+
+/* The bits of the w-th word that hold an actual cell. */
+uint64_t _valid_bits(const column* const c, const size_t w)
+{
+  const size_t first = w * COLUMN_WORD_BITS;
+  const size_t count = (size_t) c->height - first;
+  return count >= COLUMN_WORD_BITS ? UINT64_MAX : (UINT64_C(1) << count) - 1;
+}
+
+/* Same as column_fall(), for columns spanning several words. */
+bool _fall_words(column* const c, const size_t words)
+{
+  size_t high = (size_t) c->height;
+  size_t low = 0;
+  for (size_t w = 0; w < words; ++w)
+  {
+    uint64_t taken = 0;
+    for (size_t p = 0; p < COLUMN_PLANES; ++p)
+      taken |= *_word(c, p, w);
+    const uint64_t empty = ~taken & _valid_bits(c, w);
+    if (!empty)
+      continue;
+    const size_t base = w * COLUMN_WORD_BITS;
+    if (high == (size_t) c->height)
+      high = base + (size_t) __builtin_ctzll(empty);
+    low = base + COLUMN_WORD_BITS - 1 - (size_t) __builtin_clzll(empty);
+  }
+  if (low <= high || high == (size_t) c->height)
+    return false;
+
+  /* Walk the words backwards so that the carry reads the original walls. */
+  bool moved = false;
+  for (size_t w = words; w-- > 0;)
+  {
+    const size_t base = w * COLUMN_WORD_BITS;
+    if (base > low || base + COLUMN_WORD_BITS <= high + 1)
+      continue;
+    uint64_t range = UINT64_MAX;
+    if (low - base < COLUMN_WORD_BITS - 1)
+      range &= UINT64_MAX >> (COLUMN_WORD_BITS - 1 - (low - base));
+    if (high + 1 > base)
+      range &= UINT64_MAX << (high + 1 - base);
+
+    uint64_t* const wall = _word(c, COLUMN_WALL_PLANE, w);
+    const uint64_t carry = w > 0 ? *_word(c, COLUMN_WALL_PLANE, w - 1) >> 63 : 0;
+    const uint64_t fallen = (*wall << 1 | carry) & range & ~*wall;
+    if (!fallen)
+      continue;
+    moved = true;
+    *wall |= fallen;
+    for (size_t p = 1; p < COLUMN_PLANES; ++p)
+      *_word(c, p, w) &= ~fallen;
+  }
+  return moved;
+}
+
+/* Scalar version of one lane of column_fall_many(). */
+bool _fall_lane(uint64_t* const words, const size_t stride, const uint64_t valid)
+{
+  const uint64_t wall = words[0];
+  const uint64_t taken = wall | words[stride] | words[2 * stride] | words[3 * stride];
+  const uint64_t empty = ~taken & valid;
+  uint64_t before = empty;
+  for (unsigned shift = 1; shift < COLUMN_WORD_BITS; shift *= 2)
+    before |= before >> shift;
+  const uint64_t after = 0 - ((empty & (0 - empty)) << 1);
+  const uint64_t fallen = wall << 1 & before & after & ~wall;
+
+  words[0] = wall | fallen;
+  for (size_t p = 1; p < COLUMN_PLANES; ++p)
+    words[p * stride] &= ~fallen;
+  return fallen != 0;
+}
+
+#ifdef COLUMN_CHECK_FALL
+#ifndef COLUMN_CHECK_ROUNDS
+  #define COLUMN_CHECK_ROUNDS 200000
+#endif
+
+int main(void)
+{
+#if defined(__AVX2__)
+  const char* const path = "AVX2";
+  if (!__builtin_cpu_supports("avx2"))
+  {
+    printf("column_fall_many (%s): not supported here, skipped\n", path);
+    return EXIT_SUCCESS;
+  }
+#elif defined(__SSE2__)
+  const char* const path = "SSE2";
+#else
+  const char* const path = "scalar";
+#endif
+
+  enum { LANES = 75, PAD = 5, DIRTY = (LANES + COLUMN_WORD_BITS - 1) / COLUMN_WORD_BITS, };
+  uint64_t simd[COLUMN_PLANES * (LANES + PAD)];
+  uint64_t scalar[COLUMN_PLANES * (LANES + PAD)];
+  uint64_t simd_dirty[DIRTY];
+  uint64_t scalar_dirty[DIRTY];
+  prng r;
+  prng_seed(&r, 1);
+
+  for (long round = 0; round < COLUMN_CHECK_ROUNDS; ++round)
+  {
+    const size_t count = 1 + (size_t) prng_random(&r) % LANES;
+    const size_t stride = count + (size_t) prng_random(&r) % PAD;
+    const int height = 1 + (int) (prng_random(&r) % COLUMN_WORD_BITS);
+    const uint64_t valid = height >= COLUMN_WORD_BITS
+        ? UINT64_MAX : (UINT64_C(1) << height) - 1;
+
+    /* Sparse planes, so that most columns have empty cells to fall into. */
+    for (size_t i = 0; i < COLUMN_PLANES * stride; ++i)
+    {
+      const uint64_t a = (uint64_t) prng_random(&r) << 32 ^ (uint64_t) prng_random(&r);
+      const uint64_t b = (uint64_t) prng_random(&r) << 32 ^ (uint64_t) prng_random(&r);
+      simd[i] = (i < stride ? a : a & b & (uint64_t) prng_random(&r)) & valid;
+    }
+    for (size_t i = 0; i < DIRTY; ++i)
+      simd_dirty[i] = (uint64_t) prng_random(&r) << 32 ^ (uint64_t) prng_random(&r);
+    /* As in a terrain, the columns out of the dirty set have settled. */
+    for (size_t k = 0; k < count; ++k)
+    {
+      column view = { .words = simd + k, .height = height, .stride = stride, };
+      if (!(simd_dirty[k / COLUMN_WORD_BITS] >> (k % COLUMN_WORD_BITS) & 1))
+        while (column_fall(&view))
+          continue;
+    }
+    memcpy(scalar, simd, sizeof *simd * COLUMN_PLANES * stride);
+    memcpy(scalar_dirty, simd_dirty, sizeof simd_dirty);
+
+    const size_t processed = column_fall_many(simd, count, stride, height, simd_dirty);
+    size_t expected = 0;
+    for (size_t k = 0; k < count; ++k)
+    {
+      const uint64_t bit = UINT64_C(1) << (k % COLUMN_WORD_BITS);
+      if (!(scalar_dirty[k / COLUMN_WORD_BITS] & bit))
+        continue;
+      ++expected;
+      column view = { .words = scalar + k, .height = height, .stride = stride, };
+      if (!column_fall(&view))
+        scalar_dirty[k / COLUMN_WORD_BITS] &= ~bit;
+    }
+
+    if (processed != expected
+        || memcmp(simd, scalar, sizeof *simd * COLUMN_PLANES * stride)
+        || memcmp(simd_dirty, scalar_dirty, sizeof simd_dirty))
+    {
+      fprintf(stderr, "column_fall_many (%s): round %ld differs from column_fall() "
+          "(%zu columns, stride %zu, height %d)\n", path, round, count, stride, height);
+      return EX_SOFTWARE;
+    }
+  }
+
+  printf("column_fall_many (%s): %d rounds match column_fall()\n", path, COLUMN_CHECK_ROUNDS);
+  return EXIT_SUCCESS;
 }
+#endif
@@ -18,18 +18,41 @@
  */
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
 #include "cell.h"
 
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* One bit per cell and per plane, 64 cells per word. */
+#define COLUMN_WORD_BITS 64
+/* The wall plane, then three overlay planes holding the other cells. */
+#define COLUMN_PLANES 4
+#define COLUMN_WALL_PLANE 0
+
 ////////////////////////////////////////////////////////////////////////////////
 // types
 ////////////////////////////////////////////////////////////////////////////////
 
 typedef struct column column;
 
+/*
+ * A column is stored as bitboards: bit i of the wall plane is set when cell i
+ * is a wall, and for any other cell the three overlay planes hold the bits of
+ * its cell value (all zero for CELL_EMPTY). Plane p is made of
+ * column_words(height) words, word w of plane p being
+ * words[(p * column_words(height) + w) * stride].
+ *
+ * A column is either a standalone heap block (stride 1) or a view into a
+ * terrain grid, in which case consecutive words are stride words apart.
+ */
 struct column
 {
-	cell* cells;
+	uint64_t* words;
 	int height;
+	size_t stride;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -38,18 +61,27 @@ struct column
 
 column* column_new(int height, int low, int high);
 void column_destroy(column* c);
+size_t column_words(int height);
 
 ////////////////////////////////////////////////////////////////////////////////
 // getters
 ////////////////////////////////////////////////////////////////////////////////
 
 cell column_get_cell(const column* c, size_t i);
+bool column_is_wall(const column* c, size_t i);
+uint64_t column_occupied(const column* c, size_t w);
+uint64_t column_walls(const column* c, size_t w);
+uint64_t column_hash(const column* c, uint64_t key);
+uint64_t column_hash_word(const column* c, uint64_t key, size_t w);
 
 ////////////////////////////////////////////////////////////////////////////////
 // setters / modifiers
 ////////////////////////////////////////////////////////////////////////////////
 
 void column_set_cell(column* c, size_t i, cell x);
-void column_fall(column* c);
+void column_reset(column* c, int low, int high);
+bool column_fall(column* c);
+size_t column_fall_many(
+    uint64_t* words, size_t count, size_t stride, int height, uint64_t* dirty);
 
 #endif
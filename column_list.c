@@ -7,6 +7,8 @@
 
 #include <stdlib.h>
 
+#include "node_pool.h"
+
 struct column_list
 {
 	column *c;
@@ -34,11 +36,10 @@ void column_list_destroy(column_list* const l)
     return;
   column_list *tmp = l;
   while(tmp) {
-    tmp = l->suivant;
-    if(l->c->cells)
-      free(l->c->cells);
-    free(l->c);
-    free(l);
+    column_list *suivant = tmp->suivant;
+    column_destroy(tmp->c);
+    node_pool_free(tmp);
+    tmp = suivant;
   } 
   return;
 }
@@ -75,7 +76,7 @@ size_t column_list_get_size(const column_list* const l)
 
 column_list* column_list_push_front(column_list* const l, column* const c)
 {
-  column_list* const nouvelle_colonne = malloc(sizeof(*nouvelle_colonne));
+  column_list* const nouvelle_colonne = node_pool_alloc(sizeof(*nouvelle_colonne));
   nouvelle_colonne->c = c;
   nouvelle_colonne->suivant = l;
   return nouvelle_colonne;
@@ -83,14 +84,15 @@ column_list* column_list_push_front(column_list* const l, column* const c)
 
 column_list* column_list_push_back(column_list* const l, column* const c)
 {
-  column_list* const nouvelle_colonne = malloc(sizeof(*nouvelle_colonne));
-  column_list *tmp = l;
+  column_list* const nouvelle_colonne = node_pool_alloc(sizeof(*nouvelle_colonne));
+  nouvelle_colonne->c = c;
+  nouvelle_colonne->suivant = NULL;
+  if (!l)
+    return nouvelle_colonne;
 
+  column_list *tmp = l;
   while (tmp->suivant)
     tmp = column_list_suivant(tmp);
-
-  nouvelle_colonne->c = c;
-  nouvelle_colonne->suivant = NULL;
   tmp->suivant = nouvelle_colonne;
 
   return l;
@@ -99,24 +101,30 @@ column_list* column_list_push_back(column_list* const l, column* const c)
 column_list *column_list_pop_front(column_list *const l)
 {
   if(!l->suivant){
-    free(l);
+    node_pool_free(l);
     return NULL;
   }
   else{
     column_list* cur = l->suivant;
-    free(l);
+    node_pool_free(l);
     return cur;
   }
 }
 
 column_list* column_list_pop_back(column_list* const l)
 {
+  column_list *precedent = NULL;
   column_list *tmp = l;
 
-  while (tmp->suivant)
+  while (tmp->suivant) {
+    precedent = tmp;
     tmp = column_list_suivant(tmp);
+  }
 
-  free(tmp);
+  node_pool_free(tmp);
+  if (!precedent)
+    return NULL;
+  precedent->suivant = NULL;
 
   return l;
 }
@@ -0,0 +1,139 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "column_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * head and tail only grow, the slot of index i is i & mask. They live on
+ * different cache lines so that the two threads don't fight over one line.
+ */
+struct column_queue
+{
+  _Alignas(64) atomic_size_t head;
+  _Alignas(64) atomic_size_t tail;
+  _Alignas(64) size_t mask;
+  column* slots;
+  uint64_t* words;
+  prng* generators;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+column_queue* column_queue_new(const size_t capacity, const int height)
+{
+  column_queue* const q = aligned_alloc(_Alignof(column_queue), sizeof *q);
+  if (!q)
+  {
+    perror("aligned_alloc");
+    exit(EX_OSERR);
+  }
+
+  /* Round the capacity up to a power of two. */
+  size_t size = 1;
+  while (size < capacity)
+    size *= 2;
+  const size_t words = COLUMN_PLANES * column_words(height);
+  q->slots = malloc(sizeof *q->slots * size);
+  q->words = malloc(sizeof *q->words * words * size);
+  q->generators = malloc(sizeof *q->generators * size);
+  if (!q->slots || !q->words || !q->generators)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  for (size_t i = 0; i < size; ++i)
+    q->slots[i] = (column)
+    {
+      .words = q->words + i * words,
+      .height = height,
+      .stride = 1,
+    };
+
+  q->mask = size - 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+
+  return q;
+}
+
+void column_queue_destroy(column_queue* const q)
+{
+  if (!q)
+    return;
+
+  free(q->slots);
+  free(q->words);
+  free(q->generators);
+  free(q);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+/* Oldest column pushed, NULL when the queue is empty. Consumer side. */
+column* column_queue_front(column_queue* const q)
+{
+  const size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  const size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  return head == tail ? NULL : q->slots + (head & q->mask);
+}
+
+/* Next column to fill, NULL when the queue is full. Producer side. */
+column* column_queue_back(column_queue* const q)
+{
+  const size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  const size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+  return tail - head > q->mask ? NULL : q->slots + (tail & q->mask);
+}
+
+/* Only exact while neither side is running. */
+size_t column_queue_size(column_queue* const q)
+{
+  return atomic_load(&q->tail) - atomic_load(&q->head);
+}
+
+/* The generator of the slot of c, a column of the queue. */
+prng* column_queue_generator(column_queue* const q, const column* const c)
+{
+  return q->generators + (c - q->slots);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void column_queue_pop(column_queue* const q)
+{
+  const size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+}
+
+void column_queue_push(column_queue* const q)
+{
+  const size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+}
@@ -0,0 +1,62 @@
+#ifndef _COLUMN_QUEUE_H_
+#define _COLUMN_QUEUE_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+#include "column.h"
+#include "prng.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Lock-free ring of columns for exactly one producer thread and one consumer
+ * thread. The producer fills column_queue_back() then calls
+ * column_queue_push(), the consumer reads column_queue_front() then calls
+ * column_queue_pop(). Columns never move, only the indices do.
+ *
+ * Each slot also holds a generator, for the producer to leave the state it
+ * was in right after making the column.
+ */
+typedef struct column_queue column_queue;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+column_queue* column_queue_new(size_t capacity, int height);
+void column_queue_destroy(column_queue* q);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+column* column_queue_front(column_queue* q);
+column* column_queue_back(column_queue* q);
+size_t column_queue_size(column_queue* q);
+prng* column_queue_generator(column_queue* q, const column* c);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void column_queue_pop(column_queue* q);
+void column_queue_push(column_queue* q);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "effect.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * One kind of special cell: handler applies value(options) to the ship on
+ * it, and the cell is emptied. weight is the chance, out of the sum of the
+ * weights, that a secret cell turns out to be of this kind; a kind without a
+ * handler does nothing and stays, like an empty cell.
+ */
+typedef struct effect
+{
+  cell kind;
+  effect_handler handler;
+  intmax_t (*value)(const spaceship_options* o);
+  size_t weight;
+} effect;
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static void _add_ammo(effect_target target, intmax_t value);
+static void _add_bonus(effect_target target, intmax_t value);
+static intmax_t _ammo_value(const spaceship_options* o);
+static intmax_t _bonus_value(const spaceship_options* o);
+static intmax_t _malus_value(const spaceship_options* o);
+
+////////////////////////////////////////////////////////////////////////////////
+// file-scope variables
+////////////////////////////////////////////////////////////////////////////////
+
+/* Secret cells draw the kinds in this order. */
+static const effect effects[] =
+{
+  { .kind = CELL_AMMO, .handler = _add_ammo, .value = _ammo_value, .weight = 25, },
+  { .kind = CELL_BONUS, .handler = _add_bonus, .value = _bonus_value, .weight = 25, },
+  { .kind = CELL_MALUS, .handler = _add_bonus, .value = _malus_value, .weight = 25, },
+  { .kind = CELL_EMPTY, .weight = 25, },
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+void effect_table_init(effect_table* const t, const spaceship_options* const o)
+{
+  memset(t, 0, sizeof *t);
+  for (size_t i = 0; i < sizeof effects / sizeof *effects; ++i)
+  {
+    const effect* const e = effects + i;
+    t->handlers[e->kind] = e->handler;
+    t->values[e->kind] = e->value ? e->value(o) : 0;
+    if (t->total + e->weight > EFFECT_DRAWS)
+    {
+      fprintf(stderr, "effect_table_init: weights above %d.\n", EFFECT_DRAWS);
+      exit(EX_SOFTWARE);
+    }
+    memset(t->draws + t->total, e->kind, e->weight);
+    t->total += e->weight;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Apply cell c to target, a secret cell first drawing its kind from r.
+ * Returns whether the cell is used up and has to be emptied.
+ */
+bool effect_apply(
+    const effect_table* const t, cell c, prng* const r, const effect_target target)
+{
+  if (c == CELL_SECRET && t->total)
+    c = (cell) t->draws[(size_t) prng_random(r) % t->total];
+  const effect_handler handler = c < CELL_UNKNOWN ? t->handlers[c] : NULL;
+  if (!handler)
+    return false;
+  handler(target, t->values[c]);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* value is the most bullets in flight ammo cells can allow. */
+void _add_ammo(const effect_target target, const intmax_t value)
+{
+  *target.bullet_max += (intmax_t) *target.bullet_max < value ? 1 : 0;
+}
+
+void _add_bonus(const effect_target target, const intmax_t value)
+{
+  *target.bonus += value;
+}
+
+intmax_t _ammo_value(const spaceship_options* const o)
+{
+  (void) o;
+  return MAX_AMMO;
+}
+
+intmax_t _bonus_value(const spaceship_options* const o)
+{
+  return o->bonus;
+}
+
+intmax_t _malus_value(const spaceship_options* const o)
+{
+  return o->malus;
+}
@@ -0,0 +1,75 @@
+#ifndef _EFFECT_H_
+#define _EFFECT_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "cell.h"
+#include "options.h"
+#include "prng.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* The weights of the effects add up to at most this. */
+#ifndef EFFECT_DRAWS
+  #define EFFECT_DRAWS 128
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/* What the cell under a ship can change: its score and its ammo. */
+typedef struct effect_target
+{
+  intmax_t* bonus;
+  size_t* bullet_max;
+} effect_target;
+
+typedef void (*effect_handler)(effect_target target, intmax_t value);
+
+/*
+ * The effects of effect.c compiled for a set of options: the handler of
+ * each cell kind and the value it applies, and the kind a secret cell turns
+ * into for each draw in [0, total). Plain data, copied along with a game.
+ */
+typedef struct effect_table
+{
+  effect_handler handlers[CELL_UNKNOWN];
+  intmax_t values[CELL_UNKNOWN];
+  uint8_t draws[EFFECT_DRAWS];
+  size_t total;
+} effect_table;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+void effect_table_init(effect_table* t, const spaceship_options* o);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+bool effect_apply(const effect_table* t, cell c, prng* r, effect_target target);
+
+#endif
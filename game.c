@@ -14,18 +14,34 @@
  *  0. You just DO WHAT THE FUCK YOU WANT TO.
  */
 #include "game.h"
+#include "recording.h"
+#include "effect.h"
 
 #include <stdio.h>
 #include <tgmath.h>
 #include <float.h>
+#include <string.h>
 #include <sysexits.h>
 
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define GAME_SAVE_MAGIC "SSISAVE"
+#define GAME_SAVE_VERSION 2
+
 ////////////////////////////////////////////////////////////////////////////////
 // types
 ////////////////////////////////////////////////////////////////////////////////
 
+/*
+ * A game is one block of memory: the structure, then the bullets and the
+ * terrain, each at a multiple of TERRAIN_ALIGNMENT. game_clone() copies it
+ * whole and fixes up the pointers.
+ */
 struct game
 {
+  size_t size;
   spaceship_options options;
   terrain* map;
   point ship;
@@ -34,21 +50,64 @@ struct game
   double elapsed_time;
   intmax_t bonus;
   int last_key;
-  point_list* bullets;
+  bullet_array* bullets;
   size_t bullet_max;
+  prng random;
+  effect_table effects;
+  recorder* recorder;
 };
 
+/*
+ * Fixed part of a saved game, followed by the generator of the game, the
+ * living bullets as pairs of int32_t, then terrain_save(). Numbers are stored
+ * in the byte order of the machine.
+ */
+typedef struct game_record
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t prng_size;
+  uint64_t seed;
+  int64_t height;
+  int64_t width;
+  int64_t difficulty;
+  int64_t ammo;
+  int64_t bonus_value;
+  int64_t malus_value;
+  double constant_delay;
+  int64_t still;
+  int64_t large_world;
+  int64_t layout;
+  int64_t ship_x;
+  int64_t ship_y;
+  int64_t bonus;
+  int64_t last_key;
+  uint64_t bullet_max;
+  uint64_t bullets;
+  double elapsed_time;
+  double delay;
+} game_record;
+
 ////////////////////////////////////////////////////////////////////////////////
 // local functions declarations
 ////////////////////////////////////////////////////////////////////////////////
 
+static game* game_new(spaceship_options options, size_t bullet_max, FILE* file);
+static void game_rebase(game* g, const game* from);
+static size_t game_round(size_t size);
+static void game_read(FILE* file, void* data, size_t size);
+static void game_write(FILE* file, const void* data, size_t size);
 static intmax_t game_get_bonus(const game* g);
 static column* game_get_ship_column(const game* g);
 
 static void game_shift_right(game* g);
 static void game_move_bullets(game* g);
-static void game_fall(game* g);
+static bool game_fall(game* g);
 static void game_check_bullets(game* g);
+static bool game_check_bullet(game* g, size_t i, int x);
+static void game_check_fallen_bullets(game* g);
+static void game_compute_turn_reference(game* g);
+static void game_compute_turn_fused(game* g);
 static void game_check_special_cells(game* g);
 static void game_add_bonus(game* g, intmax_t bonus);
 
@@ -58,55 +117,124 @@ static void game_add_bonus(game* g, intmax_t bonus);
 
 game* game_init(const spaceship_options options)
 {
-  const int height = options.height;
-  const int w = options.width;
   const int difficulty = options.difficulty;
   const int ammo = options.ammo;
 
-  game* const g = malloc(sizeof *g);
-  if (!g)
+  size_t bullet_max;
+  if (ammo > 0)
+    bullet_max = (size_t) ammo;
+  else
+    bullet_max = difficulty < 3 ? 5 - (size_t) difficulty : 1;
+  game* const g = game_new(options, bullet_max, NULL);
+  /*
+   * Select an empty cell for the ship... we don't want the game to be over
+   * right away
+   */
+  g->ship = terrain_start_point(g->map);
+  /* Not the terrain stream: another seed gives an unrelated sequence. */
+  prng_seed(&g->random, ~options.seed);
+  g->recorder = options.record ? recorder_create(options.record, &options) : NULL;
+
+  return g;
+}
+
+/*
+ * Resume the game saved in path by game_save(). The options the rules depend
+ * on come from the file, the others (debug, engine...) from options. A game
+ * loaded this way is not recorded: a recording starts at the first turn.
+ */
+game* game_load(const char* const path, spaceship_options options)
+{
+  FILE* const file = fopen(path, "rb");
+  if (!file)
   {
-    perror("malloc");
-    exit(EX_OSERR);
+    perror(path);
+    exit(EX_NOINPUT);
+  }
+
+  game_record r;
+  game_read(file, &r, sizeof r);
+  if (memcmp(r.magic, GAME_SAVE_MAGIC, sizeof r.magic)
+      || r.version != GAME_SAVE_VERSION || r.prng_size != sizeof (prng))
+  {
+    fprintf(stderr, "%s: not a saved game or unknown version.\n", path);
+    exit(EX_DATAERR);
+  }
+
+  options.seed = r.seed;
+  options.height = (int) r.height;
+  options.width = (int) r.width;
+  options.difficulty = (int) r.difficulty;
+  options.ammo = (int) r.ammo;
+  options.bonus = r.bonus_value;
+  options.malus = r.malus_value;
+  options.constant_delay = r.constant_delay;
+  options.still = r.still;
+  options.large_world = r.large_world;
+  options.layout = (spaceship_layout) r.layout;
+  options.record = NULL;
+  if (options.autopilot && (options.width > MAX_WIDTH || options.height > MAX_HEIGHT))
+  {
+    fprintf(stderr, "%s: option '--autopilot' only flies maps up to %d x %d\n",
+        path, MAX_WIDTH, MAX_HEIGHT);
+    exit(EX_USAGE);
   }
-  terrain* const map = terrain_init(height, w, difficulty);
-  if (!map)
+
+  prng random;
+  game_read(file, &random, sizeof random);
+  point* const bullets = malloc(sizeof *bullets * (r.bullets + 1));
+  if (!bullets)
   {
     perror("malloc");
     exit(EX_OSERR);
   }
-  /*
-   * Select an empty cell for the ship... we don't want the game to be over
-   * right away
-   */
-  const point ship = terrain_start_point(map);
+  for (uint64_t i = 0; i < r.bullets; ++i)
+  {
+    int32_t xy[2];
+    game_read(file, xy, sizeof xy);
+    bullets[i] = point_xy(xy[0], xy[1]);
+  }
 
-  g->ship = ship;
-  g->map = map;
-  g->last_key = 0;
-  g->debug = options.debug;
-  g->options = options;
-  g->bonus = 0;
-  g->elapsed_time = 0.0;
-  if (ammo > 0)
-    g->bullet_max = (size_t) ammo;
-  else
-    g->bullet_max = difficulty < 3 ? 5 - (size_t) difficulty : 1;
-  g->bullets = point_list_new();
-  g->delay = DBL_MIN;
+  game* const g = game_new(options, (size_t) r.bullet_max, file);
+  fclose(file);
+
+  g->ship = point_xy((int) r.ship_x, (int) r.ship_y);
+  g->bonus = r.bonus;
+  g->last_key = (int) r.last_key;
+  g->elapsed_time = r.elapsed_time;
+  g->delay = r.delay;
+  g->random = random;
+  for (uint64_t i = 0; i < r.bullets && i < r.bullet_max; ++i)
+    bullet_array_push(g->bullets, bullets[i]);
+  free(bullets);
 
   return g;
 }
 
+/*
+ * A copy to play ahead with: it has its own map and bullets, and is never
+ * recorded. See terrain_rebase() for what it knows of the columns to come.
+ */
+game* game_clone(const game* const g)
+{
+  game* const copy = aligned_alloc(TERRAIN_ALIGNMENT, g->size);
+  if (!copy)
+  {
+    perror("aligned_alloc");
+    exit(EX_OSERR);
+  }
+  memcpy(copy, g, g->size);
+  game_rebase(copy, g);
+  return copy;
+}
+
 void game_destroy(game* const g)
 {
   if (!g)
     return;
 
-  if (g->map)
-    terrain_destroy(g->map);
-  if (g->bullets)
-    point_list_destroy(g->bullets);
+  terrain_destroy(g->map);
+  recorder_close(g->recorder, g->elapsed_time);
   free(g);
 }
 
@@ -136,6 +264,66 @@ double game_get_constant_delay(const game* const g)
   return g->options.constant_delay;
 }
 
+/*
+ * FNV-1a over everything that the rules depend on, computed from scratch:
+ * two games with the same hash play the same from now on.
+ */
+uint64_t game_hash(const game* const g)
+{
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  const uint64_t prime = UINT64_C(0x100000001b3);
+#define HASH(value) (hash = (hash ^ (uint64_t) (value)) * prime)
+  const terrain* const map = g->map;
+  const int width = terrain_width(map);
+  const int height = terrain_height(map);
+  for (int x = 0; x < width; ++x)
+    for (int y = 0; y < height; ++y)
+    {
+      const cell c = terrain_get_cell(map, (size_t) x, (size_t) y);
+      HASH(c);
+    }
+
+  HASH(g->ship.x);
+  HASH(g->ship.y);
+  HASH(g->bonus);
+  const size_t count = bullet_array_get_size(g->bullets);
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (!bullet_array_is_alive(g->bullets, i))
+      continue;
+    const point bullet = bullet_array_get_point(g->bullets, i);
+    HASH(bullet.x);
+    HASH(bullet.y);
+  }
+#undef HASH
+  return hash;
+}
+
+/*
+ * Cheaper than game_hash() for a check on every turn: the map part is kept
+ * up to date by the terrain, only the ship and the bullets are hashed here.
+ */
+uint64_t game_get_hash(const game* const g)
+{
+  uint64_t hash = terrain_hash(g->map);
+#define HASH(value) (hash = prng_mix(hash ^ (uint64_t) (value)))
+  HASH(g->ship.x);
+  HASH(g->ship.y);
+  HASH(g->bonus);
+  HASH(g->bullet_max);
+  const size_t count = bullet_array_get_size(g->bullets);
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (!bullet_array_is_alive(g->bullets, i))
+      continue;
+    const point bullet = bullet_array_get_point(g->bullets, i);
+    HASH(bullet.x);
+    HASH(bullet.y);
+  }
+#undef HASH
+  return hash;
+}
+
 spaceship_options game_get_options(const game* const g)
 {
   return g->options;
@@ -158,10 +346,10 @@ size_t game_get_max_ammo(const game* const g)
 
 size_t game_get_fired_bullets(const game* const g)
 {
-  return point_list_get_size(g->bullets);
+  return bullet_array_get_size(g->bullets);
 }
 
-point_list* game_get_bullets(const game* const g)
+const bullet_array* game_get_bullets(const game* const g)
 {
   return g->bullets;
 }
@@ -175,8 +363,7 @@ bool game_ship_is_alive(const game* const g)
 {
   const point ship = g->ship;
   const column* const c = game_get_ship_column(g);
-  const cell position = column_get_cell(c, (size_t) ship.y);
-  return position != CELL_WALL;
+  return !column_is_wall(c, (size_t) ship.y);
 }
 
 
@@ -184,7 +371,106 @@ bool game_ship_is_alive(const game* const g)
 // setters / modifiers
 ////////////////////////////////////////////////////////////////////////////////
 
+/*
+ * Save the game to path, see game_load(). The file is written next to it
+ * then renamed, so that a crash leaves either the old save or the new one.
+ */
+void game_save(game* const g, const char* const path)
+{
+  const size_t length = strlen(path);
+  char* const temporary = malloc(length + sizeof ".tmp");
+  if (!temporary)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  memcpy(temporary, path, length);
+  memcpy(temporary + length, ".tmp", sizeof ".tmp");
+
+  FILE* const file = fopen(temporary, "wb");
+  if (!file)
+  {
+    perror(temporary);
+    exit(EX_CANTCREAT);
+  }
+
+  const spaceship_options o = g->options;
+  size_t living = 0;
+  const size_t count = bullet_array_get_size(g->bullets);
+  for (size_t i = 0; i < count; ++i)
+    living += bullet_array_is_alive(g->bullets, i);
+  game_record r =
+  {
+    .version = GAME_SAVE_VERSION,
+    .prng_size = sizeof (prng),
+    .seed = o.seed,
+    .height = o.height,
+    .width = o.width,
+    .difficulty = o.difficulty,
+    .ammo = o.ammo,
+    .bonus_value = o.bonus,
+    .malus_value = o.malus,
+    .constant_delay = o.constant_delay,
+    .still = o.still,
+    .large_world = o.large_world,
+    .layout = o.layout,
+    .ship_x = g->ship.x,
+    .ship_y = g->ship.y,
+    .bonus = g->bonus,
+    .last_key = g->last_key,
+    .bullet_max = g->bullet_max,
+    .bullets = living,
+    .elapsed_time = g->elapsed_time,
+    .delay = g->delay,
+  };
+  memcpy(r.magic, GAME_SAVE_MAGIC, sizeof r.magic);
+  game_write(file, &r, sizeof r);
+  game_write(file, &g->random, sizeof g->random);
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (!bullet_array_is_alive(g->bullets, i))
+      continue;
+    const point bullet = bullet_array_get_point(g->bullets, i);
+    const int32_t xy[2] = { bullet.x, bullet.y, };
+    game_write(file, xy, sizeof xy);
+  }
+  terrain_save(g->map, file);
+
+  if (fclose(file) || rename(temporary, path))
+  {
+    perror(path);
+    exit(EX_IOERR);
+  }
+  free(temporary);
+}
+
+/*
+ * Make g, a copy from game_clone(), the same game as from again: from must
+ * have the same map size and bullet_max as the game g was cloned from.
+ */
+void game_restore(game* const g, const game* const from)
+{
+  if (g->size != from->size)
+  {
+    fprintf(stderr, "game_restore: games of different sizes.\n");
+    exit(EX_SOFTWARE);
+  }
+  memcpy(g, from, from->size);
+  game_rebase(g, from);
+}
+
 void game_compute_turn(game* const g)
+{
+  if (g->recorder)
+    recorder_turn(g->recorder, g->elapsed_time);
+  if (g->options.engine == ENGINE_REFERENCE)
+    game_compute_turn_reference(g);
+  else
+    game_compute_turn_fused(g);
+}
+
+/* The rules, one step at a time. */
+void game_compute_turn_reference(game* const g)
 {
   game_check_special_cells(g);
   game_check_bullets(g);
@@ -215,7 +501,10 @@ void game_process_input(game* const g, const int key)
 
   terrain* const map = g->map;
   const int width = terrain_width(map);
-  const size_t fired = point_list_get_size(g->bullets);
+  const size_t fired = bullet_array_get_size(g->bullets);
+
+  if (g->recorder)
+    recorder_key(g->recorder, g->elapsed_time, key);
 
   point ship = g->ship;
   const size_t x = (size_t) ship.x;
@@ -229,7 +518,7 @@ void game_process_input(game* const g, const int key)
         /* vim mode: move with h, j, k, l! */
         break;
       if (y > 0
-          && terrain_get_cell(map, x, y - 1) != CELL_WALL)
+          && !terrain_is_wall(map, x, y - 1))
         ship.y--;
       break;
     /* Bas. */
@@ -240,7 +529,7 @@ void game_process_input(game* const g, const int key)
       if (difficulty >= 2 && key != 'j')
         break;
       if ((int) y < (height - 1)
-          && terrain_get_cell(map, x, y + 1) != CELL_WALL)
+          && !terrain_is_wall(map, x, y + 1))
         ship.y++;
       break;
     /* Gauche. */
@@ -251,7 +540,7 @@ void game_process_input(game* const g, const int key)
       if (difficulty >= 2 && key != 'h')
         break;
       if (x >= 1 &&
-          terrain_get_cell(map, x - 1, y) != CELL_WALL)
+          !terrain_is_wall(map, x - 1, y))
         ship.x--;
 
       if (ship.x <= 0 && g->options.difficulty <= 0)
@@ -259,7 +548,7 @@ void game_process_input(game* const g, const int key)
         /* Si on a atteint le bord gauche. */
         terrain_left(map);
         ship.x++;
-        point_list_shift_right(g->bullets);
+        bullet_array_shift(g->bullets, 1);
       }
       break;
     /* Droite. */
@@ -270,7 +559,7 @@ void game_process_input(game* const g, const int key)
       if (difficulty >= 2 && key != 'l')
         break;
       if ((int) x < width
-          && terrain_get_cell(map, x + 1, y) != CELL_WALL)
+          && !terrain_is_wall(map, x + 1, y))
         ship.x++;
 
       if (ship.x >= width - 1)
@@ -278,7 +567,7 @@ void game_process_input(game* const g, const int key)
         /* Si on a atteint le bord droit. */
         terrain_right(map);
         ship.x--;
-        point_list_shift_left(g->bullets);
+        bullet_array_shift(g->bullets, -1);
       }
       break;
     /* Space. */
@@ -286,9 +575,9 @@ void game_process_input(game* const g, const int key)
       if (fired < g->bullet_max)
       {
         point p = (point) { .x = ship.x + 1, .y = ship.y };
-        if (!point_list_contains(g->bullets, p))
+        if (!bullet_array_contains(g->bullets, p))
         {
-          g->bullets = point_list_push_back(g->bullets, p);
+          bullet_array_push(g->bullets, p);
           game_add_bonus(g, -20 * (intmax_t) ((fired + 1) * (fired + 1)));
         }
       }
@@ -308,6 +597,77 @@ void game_process_input(game* const g, const int key)
 // local functions definitions
 ////////////////////////////////////////////////////////////////////////////////
 
+/*
+ * What game_init() and game_load() have in common: the map is read from file
+ * when there is one.
+ */
+game* game_new(const spaceship_options options, const size_t bullet_max, FILE* const file)
+{
+  const size_t capacity = bullet_max > MAX_AMMO ? bullet_max : MAX_AMMO;
+  const size_t bullets = game_round(sizeof (game));
+  const size_t map = bullets + game_round(
+      bullet_array_footprint(capacity, options.width, options.height));
+  const size_t size = map + game_round(terrain_footprint(options));
+  game* const g = aligned_alloc(TERRAIN_ALIGNMENT, size);
+  if (!g)
+  {
+    perror("aligned_alloc");
+    exit(EX_OSERR);
+  }
+
+  g->size = size;
+  g->ship = point_xy(0, 0);
+  g->map = file
+      ? terrain_load((char*) g + map, options, file)
+      : terrain_init((char*) g + map, options);
+  g->last_key = 0;
+  g->debug = options.debug;
+  g->options = options;
+  g->bonus = 0;
+  g->elapsed_time = 0.0;
+  g->bullet_max = bullet_max;
+  effect_table_init(&g->effects, &options);
+  g->bullets = bullet_array_init(
+      (char*) g + bullets, capacity, options.width, options.height);
+  g->delay = DBL_MIN;
+  g->recorder = NULL;
+  return g;
+}
+
+/* Point g, a memcpy() of from, at its own bullets and map. */
+void game_rebase(game* const g, const game* const from)
+{
+  g->bullets = (bullet_array*) ((char*) g + ((const char*) from->bullets - (const char*) from));
+  bullet_array_rebase(g->bullets);
+  g->map = (terrain*) ((char*) g + ((const char*) from->map - (const char*) from));
+  terrain_rebase(g->map, from->map);
+  g->recorder = NULL;
+}
+
+/* aligned_alloc() wants a multiple of the alignment, and so do the parts. */
+size_t game_round(const size_t size)
+{
+  return (size + TERRAIN_ALIGNMENT - 1) / TERRAIN_ALIGNMENT * TERRAIN_ALIGNMENT;
+}
+
+void game_read(FILE* const file, void* const data, const size_t size)
+{
+  if (fread(data, 1, size, file) != size)
+  {
+    fprintf(stderr, "load: truncated game.\n");
+    exit(EX_DATAERR);
+  }
+}
+
+void game_write(FILE* const file, const void* const data, const size_t size)
+{
+  if (fwrite(data, 1, size, file) != size)
+  {
+    perror("save");
+    exit(EX_IOERR);
+  }
+}
+
 void game_add_bonus(game* const g, const intmax_t bonus)
 {
   g->bonus += bonus;
@@ -320,7 +680,7 @@ intmax_t game_get_bonus(const game* const g)
 
 void game_move_bullets(game* const g)
 {
-  point_list_shift_right(g->bullets);
+  bullet_array_shift(g->bullets, 1);
 }
 
 void game_shift_right(game* const g)
@@ -328,55 +688,28 @@ void game_shift_right(game* const g)
   terrain_right(g->map);
 }
 
+/* The cell under the ship takes effect, see effect.c. */
 void game_check_special_cells(game* const g)
 {
-  const spaceship_options options = g->options;
-  const point ship = g->ship;
-  column* const c = game_get_ship_column(g);
-
-  cell position = column_get_cell(c, (size_t) ship.y);
-  if (position == CELL_SECRET)
-  {
-    const int selector = (int) random() % 100;
-    if (selector < 25)
-      position = CELL_AMMO;
-    else if (selector < 50)
-      position = CELL_BONUS;
-    else if (selector < 75)
-      position = CELL_MALUS;
-    else
-      position = CELL_EMPTY;
-  }
-
-  if (position == CELL_AMMO)
-  {
-    g->bullet_max += g->bullet_max < 10 ? 1 : 0;
-    column_set_cell(c, (size_t) ship.y, CELL_EMPTY);
-  }
-  else if (position == CELL_BONUS)
-  {
-    game_add_bonus(g, options.bonus);
-    column_set_cell(c, (size_t) ship.y, CELL_EMPTY);
-  }
-  else if (position == CELL_MALUS)
-  {
-    game_add_bonus(g, options.malus);
-    column_set_cell(c, (size_t) ship.y, CELL_EMPTY);
-  }
+  const size_t x = (size_t) g->ship.x;
+  const size_t y = (size_t) g->ship.y;
+  const cell position = terrain_get_cell(g->map, x, y);
+  const effect_target target = { .bonus = &g->bonus, .bullet_max = &g->bullet_max, };
+  if (effect_apply(&g->effects, position, &g->random, target))
+    terrain_set_cell(g->map, x, y, CELL_EMPTY);
 }
 
 column* game_get_ship_column(const game* g)
 {
   terrain* const map = g->map;
   const point ship = g->ship;
-  const column_list* columns = terrain_get_columns(map);
-  column* const c = column_list_get_column(columns, (size_t) ship.x);
+  column* const c = terrain_get_column(map, (size_t) ship.x);
   return c;
 }
 
-void game_fall(game* const g)
+bool game_fall(game* const g)
 {
-  terrain_fall(g->map);
+  return terrain_fall(g->map);
 }
 
 void game_check_bullets(game* const g)
@@ -385,22 +718,109 @@ void game_check_bullets(game* const g)
   const point up_left = { .x = 0, .y = 0, };
   const point bottom_right = { .x = options.width, .y = options.height, };
 
-  const column_list* map = terrain_get_columns(g->map);
+  terrain* const map = g->map;
 
-  g->bullets = point_list_prune_out_of_bounds(g->bullets, up_left, bottom_right);
-  const size_t count = point_list_get_size(g->bullets);
+  /* Bullets outside of the map have no column and are pruned below. */
+  const size_t count = bullet_array_get_size(g->bullets);
   for (size_t i = 0; i < count; ++i)
   {
-    const point position = point_list_get_point(g->bullets, i);
-    if (point_is_valid(position))
+    const point position = bullet_array_get_point(g->bullets, i);
+    if (!bullet_array_is_alive(g->bullets, i) || !point_is_valid(position))
+      continue;
+    column* const c = terrain_get_column(map, (size_t) position.x);
+    if (c && column_get_cell(c, (size_t) position.y) != CELL_EMPTY)
+    {
+      terrain_set_cell(map, (size_t) position.x, (size_t) position.y, CELL_EMPTY);
+      bullet_array_kill(g->bullets, i);
+    }
+  }
+  bullet_array_prune(g->bullets, up_left, bottom_right);
+}
+
+/* Check one bullet against column x of its row, as game_check_bullets(). */
+bool game_check_bullet(game* const g, const size_t i, const int x)
+{
+  const point position = bullet_array_get_point(g->bullets, i);
+  const column* const c = x >= 0 ? terrain_get_column(g->map, (size_t) x) : NULL;
+  if (!c || column_get_cell(c, (size_t) position.y) == CELL_EMPTY)
+    return false;
+
+  terrain_set_cell(g->map, (size_t) x, (size_t) position.y, CELL_EMPTY);
+  bullet_array_kill(g->bullets, i);
+  return true;
+}
+
+/*
+ * game_check_bullets() after terrain_fall(): only the columns where a wall
+ * moved can hold a new hit, and the occupancy bitmap gives them all at once.
+ */
+void game_check_fallen_bullets(game* const g)
+{
+  terrain* const map = g->map;
+  const size_t width = (size_t) terrain_width(map);
+  const size_t words = column_words(terrain_height(map));
+  if (!bullet_array_get_size(g->bullets))
+    return;
+
+  for (size_t dx = terrain_next_dirty(map, 0); dx < width;
+      dx = terrain_next_dirty(map, dx + 1))
+  {
+    const int x = (int) dx;
+    const column* const c = terrain_get_column(map, dx);
+    for (size_t w = 0; w < words; ++w)
     {
-      column* const c = column_list_get_column(map, (size_t) position.x);
-      if (c && column_get_cell(c, (size_t) position.y) != CELL_EMPTY)
+      uint64_t hits = bullet_array_occupied(g->bullets, x, w) & column_occupied(c, w);
+      for (; hits; hits &= hits - 1)
       {
-        column_set_cell(c, (size_t) position.y, CELL_EMPTY);
-        point_list_set_point(g->bullets, i, point_invalid());
+        const int y = (int) (w * COLUMN_WORD_BITS) + __builtin_ctzll(hits);
+        terrain_set_cell(map, (size_t) x, (size_t) y, CELL_EMPTY);
+        bullet_array_kill_at(g->bullets, point_xy(x, y));
       }
     }
   }
-  g->bullets = point_list_prune_out_of_bounds(g->bullets, up_left, bottom_right);
+}
+
+/*
+ * Same result as game_compute_turn_reference() with a single sweep over the
+ * bullets before gravity. Relative to the scrolled map, a bullet at x checks
+ * column x - 1 (before the scroll), x (after it) then x + 1 (after moving).
+ *
+ * A bullet only shares cells with the bullets on its right in the same row,
+ * and the reference turn always lets those check the shared cells first:
+ * the bullets are sorted by decreasing x, so going through them in order does
+ * the same.
+ */
+void game_compute_turn_fused(game* const g)
+{
+  const spaceship_options options = g->options;
+  const point up_left = { .x = 0, .y = 0, };
+  const point bottom_right = { .x = options.width, .y = options.height, };
+  bullet_array* const bullets = g->bullets;
+
+  game_check_special_cells(g);
+  bullet_array_prune(bullets, up_left, bottom_right);
+  const size_t count = bullet_array_get_size(bullets);
+
+  /* Column 0 goes away with the scroll: the bullets there check it now. */
+  for (size_t i = count; i > 0 && bullet_array_get_point(bullets, i - 1).x == 0; --i)
+    game_check_bullet(g, i - 1, 0);
+  game_shift_right(g);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    const int x = bullet_array_get_point(bullets, i).x;
+    if (!bullet_array_is_alive(bullets, i))
+      continue;
+    if (x > 0 && game_check_bullet(g, i, x - 1))
+      continue;
+    if (!game_check_bullet(g, i, x))
+      game_check_bullet(g, i, x + 1);
+  }
+  game_move_bullets(g);
+
+  /* Bullets survived the cells they are on unless gravity moved a wall. */
+  if (game_fall(g))
+    game_check_fallen_bullets(g);
+  bullet_array_prune(bullets, up_left, bottom_right);
+  game_check_special_cells(g);
 }
@@ -22,7 +22,7 @@
 #include <inttypes.h>
 
 #include "point.h"
-#include "point_list.h"
+#include "bullet_array.h"
 #include "terrain.h"
 #include "options.h"
 
@@ -37,6 +37,8 @@ typedef struct game game;
 ////////////////////////////////////////////////////////////////////////////////
 
 game* game_init(spaceship_options o);
+game* game_load(const char* path, spaceship_options o);
+game* game_clone(const game* g);
 void game_destroy(game* j);
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -47,13 +49,15 @@ bool game_ship_is_alive(const game* j);
 double game_get_delay(const game* j);
 double game_get_elapsed_time(const game* j);
 double game_get_constant_delay(const game* g);
+uint64_t game_hash(const game* g);
+uint64_t game_get_hash(const game* g);
 intmax_t game_get_score(const game* g);
 spaceship_options game_get_options(const game* g);
 terrain* game_get_map(const game* g);
 point game_get_ship_position(const game* g);
 size_t game_get_max_ammo(const game* g);
 size_t game_get_fired_bullets(const game* g);
-point_list* game_get_bullets(const game* g);
+const bullet_array* game_get_bullets(const game* g);
 int game_get_last_input(const game* g);
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -63,6 +67,8 @@ int game_get_last_input(const game* g);
 void game_process_input(game* j, int key);
 void game_set_delay(game* j, double delay);
 void game_set_elapsed_time(game* j, double t);
+void game_save(game* g, const char* path);
+void game_restore(game* g, const game* from);
 void game_compute_turn(game* j);
 
 #endif
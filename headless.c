@@ -0,0 +1,532 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sysexits.h>
+
+#include "game.h"
+#include "options.h"
+#include "recording.h"
+#include "autopilot.h"
+#include "work_pool.h"
+#include "population.h"
+#include "prng.h"
+#include "speed_curve.h"
+#include "node_pool.h"
+
+/*
+ * Runs the game without ncurses nor wall-clock pacing: the elapsed time
+ * advances by the delay of each turn, as if every turn lasted exactly that.
+ * A --replay plays the recorded keys and turns at their recorded times
+ * instead, as fast as possible or, with --realtime, at the recorded pace.
+ * A --population flies that many ships over one map, each pressing keys
+ * drawn from its own generator.
+ *
+ * The allocations made by the game code are counted by node_pool, see
+ * node_pool.h.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/* One line of the input script: key is sent just before turn tick. */
+typedef struct scripted_key
+{
+  long tick;
+  int key;
+} scripted_key;
+
+/* What is left of a game once it is over, or out of ticks. */
+typedef struct game_result
+{
+  uint64_t seed;
+  long ticks;
+  bool alive;
+  intmax_t score;
+  point position;
+  uint64_t hash;
+  autopilot_stats pilot;
+} game_result;
+
+/* --batch: game i plays with seed options.seed + i. */
+typedef struct batch
+{
+  spaceship_options options;
+  const scripted_key* script;
+  size_t count;
+  game_result* results;
+} batch;
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static bool _play(
+    spaceship_options o, const scripted_key* script, size_t count,
+    game_result* result);
+static void _replay(spaceship_options o, replay* r, game_result* result);
+static void _play_batch(size_t index, void* arg);
+static void _print_batch(const batch* b, size_t threads, double seconds);
+static long _play_population(spaceship_options o, population* p, size_t* turns);
+static void _print_population(
+    const population* p, long ticks, size_t turns, double seconds);
+static scripted_key* _read_script(const char* path, size_t* count);
+static int _parse_key(const char* token);
+static inline double _seconds(struct timespec t0, struct timespec t1);
+
+////////////////////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[static argc + 1])
+{
+  spaceship_options o = default_options();
+  check_options(&o, argc, argv);
+
+  if (o.help)
+  {
+    print_help(stdout, argv[0]);
+    return EXIT_SUCCESS;
+  }
+  if (o.invalid)
+    return EX_USAGE;
+
+  replay* const recording = o.replay ? replay_open(o.replay, &o) : NULL;
+  if (!o.seed)
+    o.seed = (uint64_t) time(NULL) + (uint64_t) getpid();
+
+  size_t count = 0;
+  scripted_key* const script = o.script ? _read_script(o.script, &count) : NULL;
+
+  struct timespec start, end;
+  const size_t before = node_pool_get_stats().heap;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if (o.population > 0 && !recording && !o.load)
+  {
+    population* const p = population_new(o, (size_t) o.population);
+    size_t turns = 0;
+    const long ticks = _play_population(o, p, &turns);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const size_t allocated = node_pool_get_stats().heap - before;
+    _print_population(p, ticks, turns, _seconds(start, end));
+    printf("allocations: %zu\n", allocated);
+
+    population_destroy(p);
+    free(script);
+    return EXIT_SUCCESS;
+  }
+
+  if (o.batch > 0 && !recording && !o.load)
+  {
+    const size_t games = (size_t) o.batch;
+    const size_t threads = o.threads > 0
+        ? (size_t) o.threads : (size_t) sysconf(_SC_NPROCESSORS_ONLN);
+    batch b = { .options = o, .script = script, .count = count, };
+    b.results = malloc(sizeof *b.results * games);
+    if (!b.results)
+    {
+      perror("malloc");
+      exit(EX_OSERR);
+    }
+
+    work_pool* const pool = work_pool_new(threads < games ? threads : games);
+    work_pool_run(pool, games, _play_batch, &b);
+    work_pool_destroy(pool);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const size_t allocated = node_pool_get_stats().heap - before;
+    _print_batch(&b, threads, _seconds(start, end));
+    printf("allocations: %zu\n", allocated);
+
+    free(b.results);
+    free(script);
+    return EXIT_SUCCESS;
+  }
+
+  game_result result;
+  bool same = true;
+  if (recording)
+    _replay(o, recording, &result);
+  else
+    same = _play(o, script, count, &result);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  const size_t allocated = node_pool_get_stats().heap - before;
+  const double seconds = _seconds(start, end);
+
+  printf("seed: %"PRIu64"\n", result.seed);
+  printf("ticks: %ld\n", result.ticks);
+  printf("alive: %s\n", result.alive ? "yes" : "no");
+  printf("score: %"PRIdMAX"\n", result.score);
+  printf("hash: %016"PRIx64"\n", result.hash);
+  printf("seconds: %.6f\n", seconds);
+  printf("ticks/second: %.0f\n", seconds > 0.0 ? (double) result.ticks / seconds : 0.0);
+  printf("allocations: %zu\n", allocated);
+  if (o.autopilot)
+    printf("autopilot: %zu nodes, %.0f nodes/second\n", result.pilot.nodes,
+        result.pilot.seconds > 0.0 ? (double) result.pilot.nodes / result.pilot.seconds : 0.0);
+
+  free(script);
+  replay_close(recording);
+
+  return same ? EXIT_SUCCESS : EX_SOFTWARE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Play one game. With --compare-engines, the other engine runs in lockstep
+ * and the game stops at the first tick where they differ: returns false.
+ */
+bool _play(
+    const spaceship_options o, const scripted_key* const script,
+    const size_t count, game_result* const result)
+{
+  spaceship_options r = o;
+  r.engine = o.engine == ENGINE_FUSED ? ENGINE_REFERENCE : ENGINE_FUSED;
+  r.record = NULL;
+  game* const g = o.load ? game_load(o.load, o) : game_init(o);
+  game* const reference = !o.compare_engines ? NULL
+      : o.load ? game_load(o.load, r) : game_init(r);
+
+  autopilot* const pilot = !o.autopilot ? NULL : autopilot_new(g, o.threads > 0
+      ? (size_t) o.threads : (size_t) sysconf(_SC_NPROCESSORS_ONLN));
+  const spaceship_options played = game_get_options(g);
+  speed_curve* const curve = speed_curve_new(&played);
+
+  bool same = true;
+  double elapsed = game_get_elapsed_time(g);
+  size_t next = 0;
+  long tick = 0;
+  for (; tick < o.ticks && game_ship_is_alive(g); ++tick)
+  {
+    const double delay = speed_curve_delay(curve, elapsed);
+    game_set_delay(g, delay);
+    game_set_elapsed_time(g, elapsed);
+    if (reference)
+    {
+      game_set_delay(reference, delay);
+      game_set_elapsed_time(reference, elapsed);
+    }
+
+    for (; next < count && script[next].tick <= tick; ++next)
+    {
+      game_process_input(g, script[next].key);
+      if (reference)
+        game_process_input(reference, script[next].key);
+    }
+    if (pilot)
+    {
+      const int key = autopilot_next_key(pilot, g);
+      game_process_input(g, key);
+      if (reference)
+        game_process_input(reference, key);
+    }
+    game_compute_turn(g);
+    elapsed += delay;
+
+    if (reference)
+    {
+      game_compute_turn(reference);
+      if (game_get_hash(g) != game_get_hash(reference))
+      {
+        fprintf(stderr, "engines diverge at tick %ld\n", tick);
+        same = false;
+        ++tick;
+        break;
+      }
+    }
+  }
+
+  *result = (game_result)
+  {
+    .seed = game_get_options(g).seed,
+    .ticks = tick,
+    .alive = game_ship_is_alive(g),
+    .score = game_get_score(g),
+    .position = game_get_ship_position(g),
+    .hash = game_hash(g),
+    .pilot = pilot ? autopilot_get_stats(pilot) : (autopilot_stats) { 0 },
+  };
+  autopilot_destroy(pilot);
+  speed_curve_destroy(curve);
+  if (o.save)
+    game_save(g, o.save);
+  game_destroy(reference);
+  game_destroy(g);
+  return same;
+}
+
+/* The options come from the recording: o is what replay_open() left. */
+void _replay(spaceship_options o, replay* const r, game_result* const result)
+{
+  o.compare_engines = false;
+  game* const g = game_init(o);
+  speed_curve* const curve = speed_curve_new(&o);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  long tick = 0;
+  for (recording_event e; replay_next(r, &e); )
+  {
+    if (o.realtime)
+    {
+      const long nanoseconds = start.tv_nsec + (long) (fmod(e.elapsed, 1.0) * 1e9);
+      const struct timespec due =
+      {
+        .tv_sec = start.tv_sec + (time_t) e.elapsed + nanoseconds / 1000000000L,
+        .tv_nsec = nanoseconds % 1000000000L,
+      };
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+        continue;
+    }
+
+    game_set_delay(g, speed_curve_delay(curve, e.elapsed));
+    game_set_elapsed_time(g, e.elapsed);
+    switch (e.kind)
+    {
+      case RECORDING_KEY:
+        game_process_input(g, e.key);
+        break;
+      case RECORDING_TURN:
+        game_compute_turn(g);
+        ++tick;
+        break;
+      case RECORDING_END:
+      default:
+        break;
+    }
+  }
+
+  *result = (game_result)
+  {
+    .seed = game_get_options(g).seed,
+    .ticks = tick,
+    .alive = game_ship_is_alive(g),
+    .score = game_get_score(g),
+    .position = game_get_ship_position(g),
+    .hash = game_hash(g),
+  };
+  speed_curve_destroy(curve);
+  game_destroy(g);
+}
+
+void _play_batch(const size_t index, void* const arg)
+{
+  batch* const b = arg;
+  spaceship_options o = b->options;
+  o.seed += index;
+  o.compare_engines = false;
+  o.record = NULL;
+  o.save = NULL;
+  /* Each game keeps its world in a temporary file of its own. */
+  o.world_file = NULL;
+  /* The games already keep every thread busy. */
+  o.threads = 1;
+  _play(o, b->script, b->count, b->results + index);
+}
+
+/* The hash of a batch doesn't depend on the order the games ran in. */
+void _print_batch(const batch* const b, const size_t threads, const double seconds)
+{
+  const size_t games = (size_t) b->options.batch;
+  size_t deaths = 0;
+  long ticks = 0;
+  intmax_t total = 0;
+  intmax_t best = INTMAX_MIN;
+  intmax_t worst = INTMAX_MAX;
+  double x = 0.0;
+  double y = 0.0;
+  uint64_t hash = 0;
+  for (size_t i = 0; i < games; ++i)
+  {
+    const game_result* const r = b->results + i;
+    ticks += r->ticks;
+    total += r->score;
+    best = r->score > best ? r->score : best;
+    worst = r->score < worst ? r->score : worst;
+    hash ^= r->hash + i;
+    if (!r->alive)
+    {
+      ++deaths;
+      x += r->position.x;
+      y += r->position.y;
+    }
+  }
+
+  printf("games: %zu\n", games);
+  printf("threads: %zu\n", threads);
+  printf("seeds: %"PRIu64" to %"PRIu64"\n", b->options.seed, b->options.seed + games - 1);
+  printf("deaths: %zu\n", deaths);
+  printf("ticks survived: %.1f on average\n", (double) ticks / (double) games);
+  printf("score: %.1f on average, %"PRIdMAX" to %"PRIdMAX"\n",
+      (double) total / (double) games, worst, best);
+  if (deaths)
+    printf("death position: (%.1f, %.1f) on average\n",
+        x / (double) deaths, y / (double) deaths);
+  printf("hash: %016"PRIx64"\n", hash);
+  printf("seconds: %.6f\n", seconds);
+  printf("games/second: %.0f\n", seconds > 0.0 ? (double) games / seconds : 0.0);
+  printf("ticks/second: %.0f\n", seconds > 0.0 ? (double) ticks / seconds : 0.0);
+}
+
+/*
+ * Play until every ship is dead or out of ticks. turns counts the turns
+ * played by each ship, summed.
+ */
+long _play_population(const spaceship_options o, population* const p, size_t* const turns)
+{
+  static const int keys[] = { 0, 'k', 'j', 'h', 'l', ' ', };
+  const size_t ships = population_get_size(p);
+  prng* const bots = malloc(sizeof *bots * ships);
+  if (!bots)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  for (size_t i = 0; i < ships; ++i)
+    prng_seed(bots + i, prng_mix(o.seed + i));
+  speed_curve* const curve = speed_curve_new(&o);
+
+  double elapsed = 0.0;
+  long tick = 0;
+  *turns = 0;
+  for (; tick < o.ticks && population_get_alive(p); ++tick)
+  {
+    population_set_elapsed_time(p, elapsed);
+    for (size_t i = 0; i < ships; ++i)
+    {
+      const size_t k = (size_t) prng_random(bots + i) % (sizeof keys / sizeof *keys);
+      population_process_input(p, i, keys[k]);
+    }
+    *turns += population_get_alive(p);
+    population_compute_turn(p);
+    elapsed += speed_curve_delay(curve, elapsed);
+  }
+
+  speed_curve_destroy(curve);
+  free(bots);
+  return tick;
+}
+
+/* Same figures as _print_batch(), the ships standing for the games. */
+void _print_population(
+    const population* const p, const long ticks, const size_t turns, const double seconds)
+{
+  const size_t ships = population_get_size(p);
+  intmax_t total = 0;
+  intmax_t best = INTMAX_MIN;
+  intmax_t worst = INTMAX_MAX;
+  size_t best_ship = 0;
+  uint64_t hash = 0;
+  for (size_t i = 0; i < ships; ++i)
+  {
+    const intmax_t score = population_get_score(p, i);
+    const point position = population_get_ship_position(p, i);
+    total += score;
+    if (score > best)
+    {
+      best = score;
+      best_ship = i;
+    }
+    worst = score < worst ? score : worst;
+    hash ^= prng_mix((uint64_t) score ^ (uint64_t) position.x << 32
+        ^ (uint64_t) position.y << 48) + i;
+  }
+
+  printf("ships: %zu\n", ships);
+  printf("seed: %"PRIu64"\n", game_get_options(population_get_world(p)).seed);
+  printf("ticks: %ld\n", ticks);
+  printf("deaths: %zu\n", ships - population_get_alive(p));
+  printf("turns survived: %.1f on average\n", (double) turns / (double) ships);
+  printf("score: %.1f on average, %"PRIdMAX" to %"PRIdMAX" (ship %zu)\n",
+      (double) total / (double) ships, worst, best, best_ship);
+  printf("hash: %016"PRIx64"\n", hash);
+  printf("seconds: %.6f\n", seconds);
+  printf("ticks/second: %.0f\n", seconds > 0.0 ? (double) ticks / seconds : 0.0);
+  printf("ship turns/second: %.0f\n", seconds > 0.0 ? (double) turns / seconds : 0.0);
+}
+
+/* Lines are "<tick> <key>", sorted by tick; anything else is skipped. */
+scripted_key* _read_script(const char* const path, size_t* const count)
+{
+  FILE* const file = fopen(path, "r");
+  if (!file)
+  {
+    perror(path);
+    exit(EX_NOINPUT);
+  }
+
+  size_t capacity = 64;
+  scripted_key* script = malloc(sizeof *script * capacity);
+  if (!script)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  *count = 0;
+  char line[256];
+  while (fgets(line, sizeof line, file))
+  {
+    long tick = 0;
+    char token[32];
+    if (sscanf(line, "%ld %31s", &tick, token) != 2)
+      continue;
+
+    if (*count == capacity)
+    {
+      capacity *= 2;
+      scripted_key* const grown = realloc(script, sizeof *script * capacity);
+      if (!grown)
+      {
+        perror("realloc");
+        exit(EX_OSERR);
+      }
+      script = grown;
+    }
+    script[(*count)++] = (scripted_key) { .tick = tick, .key = _parse_key(token), };
+  }
+
+  fclose(file);
+  return script;
+}
+
+/* A single character is sent as is, "space" is ' ', longer tokens are codes. */
+int _parse_key(const char* const token)
+{
+  if (!token[1])
+    return token[0];
+  if (!strcmp(token, "space"))
+    return ' ';
+  return atoi(token);
+}
+
+double _seconds(const struct timespec t0, const struct timespec t1)
+{
+  return (double) (t1.tv_sec - t0.tv_sec) + (double) (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
@@ -0,0 +1,166 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "node_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NODE_POOL_SLAB
+  #define NODE_POOL_SLAB 256
+#endif
+/* Big enough for the nodes of both lists. */
+#ifndef NODE_POOL_NODE_SIZE
+  #define NODE_POOL_NODE_SIZE 32
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+typedef union node
+{
+  union node* next;
+  _Alignas(max_align_t) unsigned char bytes[NODE_POOL_NODE_SIZE];
+} node;
+
+/* The first node of each slab links the slabs together. */
+typedef struct node_pool
+{
+  node* free;
+  node* slabs;
+  node_pool_stats stats;
+} node_pool;
+
+////////////////////////////////////////////////////////////////////////////////
+// file-scope variables
+////////////////////////////////////////////////////////////////////////////////
+
+static _Thread_local node_pool pool;
+/* The producer and worker threads allocate too. */
+static atomic_size_t heap;
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+void* __real_aligned_alloc(size_t alignment, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* p, size_t size);
+void* __wrap_aligned_alloc(size_t alignment, size_t size);
+
+static void _grow(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+node_pool_stats node_pool_get_stats(void)
+{
+  node_pool_stats stats = pool.stats;
+  stats.heap = atomic_load_explicit(&heap, memory_order_relaxed);
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void* node_pool_alloc(const size_t size)
+{
+  if (size > NODE_POOL_NODE_SIZE)
+  {
+    fprintf(stderr, "node_pool_alloc: %zu bytes is too big.\n", size);
+    exit(EX_SOFTWARE);
+  }
+
+  if (!pool.free)
+    _grow();
+  node* const n = pool.free;
+  pool.free = n->next;
+  ++pool.stats.allocations;
+  ++pool.stats.live;
+  return n;
+}
+
+void node_pool_free(void* const p)
+{
+  if (!p)
+    return;
+
+  node* const n = p;
+  n->next = pool.free;
+  pool.free = n;
+  ++pool.stats.frees;
+  --pool.stats.live;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+void* __wrap_malloc(const size_t size)
+{
+  atomic_fetch_add_explicit(&heap, 1, memory_order_relaxed);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(const size_t count, const size_t size)
+{
+  atomic_fetch_add_explicit(&heap, 1, memory_order_relaxed);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* const p, const size_t size)
+{
+  atomic_fetch_add_explicit(&heap, 1, memory_order_relaxed);
+  return __real_realloc(p, size);
+}
+
+void* __wrap_aligned_alloc(const size_t alignment, const size_t size)
+{
+  atomic_fetch_add_explicit(&heap, 1, memory_order_relaxed);
+  return __real_aligned_alloc(alignment, size);
+}
+
+void _grow(void)
+{
+  node* const slab = malloc(sizeof *slab * NODE_POOL_SLAB);
+  if (!slab)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  slab->next = pool.slabs;
+  pool.slabs = slab;
+  for (size_t i = NODE_POOL_SLAB - 1; i > 0; --i)
+  {
+    slab[i].next = pool.free;
+    pool.free = slab + i;
+  }
+  ++pool.stats.slabs;
+}
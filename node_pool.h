@@ -0,0 +1,57 @@
+#ifndef _NODE_POOL_H_
+#define _NODE_POOL_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Fixed-size nodes for point_list and column_list, carved out of slabs of
+ * NODE_POOL_SLAB nodes and recycled through a free list. Each thread has its
+ * own pool: a node must be freed by the thread that allocated it.
+ *
+ * heap counts every malloc() (and friends) of the whole process when it is
+ * linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,
+ * --wrap=aligned_alloc, as both binaries are.
+ */
+typedef struct node_pool_stats
+{
+  size_t allocations;
+  size_t frees;
+  size_t live;
+  size_t slabs;
+  size_t heap;
+} node_pool_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+node_pool_stats node_pool_get_stats(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void* node_pool_alloc(size_t size);
+void node_pool_free(void* node);
+
+#endif
@@ -20,6 +20,7 @@
 #include <getopt.h> 
 #include <string.h> 
 #include <ctype.h> 
+#include <strings.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 // macros
@@ -31,6 +32,19 @@
 #ifndef DEFAULT_WIDTH
   #define DEFAULT_WIDTH 30
 #endif
+#ifndef MIN_WIDTH
+  #define MIN_WIDTH 15
+#endif
+#ifndef MIN_HEIGHT
+  #define MIN_HEIGHT 6
+#endif
+/* With --large-world, the map is bigger than the screen. */
+#ifndef LARGE_MAX_WIDTH
+  #define LARGE_MAX_WIDTH 10000
+#endif
+#ifndef LARGE_MAX_HEIGHT
+  #define LARGE_MAX_HEIGHT 1000
+#endif
 #ifndef DEFAULT_PRETTY
   #define DEFAULT_PRETTY true
 #endif
@@ -43,6 +57,9 @@
 #ifndef DEFAULT_MALUS
   #define DEFAULT_MALUS -1000
 #endif
+#ifndef DEFAULT_LAYOUT
+  #define DEFAULT_LAYOUT LAYOUT_ROW_MAJOR
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // types
@@ -62,6 +79,25 @@ typedef enum spaceship_option
   OPTION_AMMO,
   OPTION_BONUS,
   OPTION_MALUS,
+  OPTION_LAYOUT,
+  OPTION_SEED,
+  OPTION_PREGENERATE,
+  OPTION_WORLD_FILE,
+  OPTION_LARGE_WORLD,
+  OPTION_ENGINE,
+  OPTION_TICKS,
+  OPTION_SCRIPT,
+  OPTION_COMPARE_ENGINES,
+  OPTION_BATCH,
+  OPTION_THREADS,
+  OPTION_RECORD,
+  OPTION_REPLAY,
+  OPTION_REALTIME,
+  OPTION_SAVE,
+  OPTION_LOAD,
+  OPTION_AUTOPILOT,
+  OPTION_POPULATION,
+  OPTION_SPEED_CURVE,
   OPTION_UNKNOWN,
 } spaceship_option;
 
@@ -83,6 +119,25 @@ static const struct option options[] =
   [OPTION_AMMO] = { "ammo", required_argument, 0, 0, },
   [OPTION_BONUS] = { "bonus", required_argument, 0, 0, },
   [OPTION_MALUS] = { "malus", required_argument, 0, 0, },
+  [OPTION_LAYOUT] = { "layout", required_argument, 0, 0, },
+  [OPTION_SEED] = { "seed", required_argument, 0, 0, },
+  [OPTION_PREGENERATE] = { "pregenerate", required_argument, 0, 0, },
+  [OPTION_WORLD_FILE] = { "world-file", required_argument, 0, 0, },
+  [OPTION_LARGE_WORLD] = { "large-world", no_argument, 0, 0, },
+  [OPTION_ENGINE] = { "engine", required_argument, 0, 0, },
+  [OPTION_TICKS] = { "ticks", required_argument, 0, 0, },
+  [OPTION_SCRIPT] = { "script", required_argument, 0, 0, },
+  [OPTION_COMPARE_ENGINES] = { "compare-engines", no_argument, 0, 0, },
+  [OPTION_BATCH] = { "batch", required_argument, 0, 0, },
+  [OPTION_THREADS] = { "threads", required_argument, 0, 0, },
+  [OPTION_RECORD] = { "record", required_argument, 0, 0, },
+  [OPTION_REPLAY] = { "replay", required_argument, 0, 0, },
+  [OPTION_REALTIME] = { "realtime", no_argument, 0, 0, },
+  [OPTION_SAVE] = { "save", required_argument, 0, 0, },
+  [OPTION_LOAD] = { "load", required_argument, 0, 0, },
+  [OPTION_AUTOPILOT] = { "autopilot", no_argument, 0, 0, },
+  [OPTION_POPULATION] = { "population", required_argument, 0, 0, },
+  [OPTION_SPEED_CURVE] = { "speed-curve", required_argument, 0, 0, },
   [OPTION_UNKNOWN] = { 0, 0, 0, 0, },
 };
 
@@ -96,18 +151,39 @@ void print_help(FILE* const stream, const char* const program)
   fprintf(stream, "\n");
 
   fprintf(stream, "Options:\n");
-  fprintf(stream, "  -h, --help                Print this help.\n");
-  fprintf(stream, "  -v, --version             Print the version.\n");
-  fprintf(stream, "  --debug                   Enable debugging mode.\n");
-  fprintf(stream, "  --still                   Play in a still world.\n");
-  fprintf(stream, "  --width=<value>           Set the width of the world.\n");
-  fprintf(stream, "  --height=<value>          Set the height of the world.\n");
-  fprintf(stream, "  --difficulty=<value>      Set the difficulty.\n");
-  fprintf(stream, "  --pretty=<true|false>     Enable/disable the pretty ui.\n");
-  fprintf(stream, "  --constant-delay=<value>  Set a constant delay.\n");
-  fprintf(stream, "  --ammo=<value>            Set the ammo amount.\n");
-  fprintf(stream, "  --bonus=<value>           Set the bonus value.\n");
-  fprintf(stream, "  --malus=<value>           Set the malus value.\n");
+  fprintf(stream, "  -h, --help                   Print this help.\n");
+  fprintf(stream, "  -v, --version                Print the version.\n");
+  fprintf(stream, "  --debug                      Enable debugging mode.\n");
+  fprintf(stream, "  --still                      Play in a still world.\n");
+  fprintf(stream, "  --width=<value>              Set the width of the world.\n");
+  fprintf(stream, "  --height=<value>             Set the height of the world.\n");
+  fprintf(stream, "  --difficulty=<value>         Set the difficulty.\n");
+  fprintf(stream, "  --pretty=<true|false>        Enable/disable the pretty ui.\n");
+  fprintf(stream, "  --constant-delay=<value>     Set a constant delay.\n");
+  fprintf(stream, "  --speed-curve=<path|points>  Set the delays, \"<seconds>:<delay>,...\".\n");
+  fprintf(stream, "  --ammo=<value>               Set the ammo amount.\n");
+  fprintf(stream, "  --bonus=<value>              Set the bonus value.\n");
+  fprintf(stream, "  --malus=<value>              Set the malus value.\n");
+  fprintf(stream, "  --layout=<column|row>        Set the memory layout of the map.\n");
+  fprintf(stream, "  --seed=<value>               Set the random seed (0: pick one).\n");
+  fprintf(stream, "  --pregenerate=<value>        Generate columns ahead in a thread.\n");
+  fprintf(stream, "  --world-file=<path>          Keep the explored world in a file.\n");
+  fprintf(stream, "  --large-world                Allow a map bigger than the screen.\n");
+  fprintf(stream, "  --engine=<fused|reference>   Set how turns are computed.\n");
+  fprintf(stream, "  --record=<path>              Record the seed, options and input.\n");
+  fprintf(stream, "  --save=<path>                Save the game there when leaving.\n");
+  fprintf(stream, "  --load=<path>                Resume a saved game.\n");
+  fprintf(stream, "  --autopilot                  Let a bot fly the ship.\n");
+  fprintf(stream, "\n");
+  fprintf(stream, "Headless options:\n");
+  fprintf(stream, "  --ticks=<value>              Set the number of turns to play.\n");
+  fprintf(stream, "  --script=<path>              Read \"<tick> <key>\" input lines.\n");
+  fprintf(stream, "  --compare-engines            Check the engines against each other.\n");
+  fprintf(stream, "  --batch=<value>              Play that many games, one seed each.\n");
+  fprintf(stream, "  --threads=<value>            Set the threads of --batch and --autopilot.\n");
+  fprintf(stream, "  --replay=<path>              Play a recording again.\n");
+  fprintf(stream, "  --realtime                   Replay at the recorded speed.\n");
+  fprintf(stream, "  --population=<value>         Fly that many ships over one map.\n");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -115,6 +191,10 @@ void print_help(FILE* const stream, const char* const program)
 ////////////////////////////////////////////////////////////////////////////////
 
 static inline bool _parse_boolean(const char* arg);
+static inline bool _parse_layout(const char* arg, spaceship_layout* layout);
+static inline bool _parse_engine(const char* arg, spaceship_engine* engine);
+static void _invalid_value(spaceship_options* o, const char* option, const char* arg);
+static inline int _clamp(int value, int min, int max);
 static void check_long_options(
     spaceship_options* const o, int option_index, const char* arg);
 
@@ -139,6 +219,25 @@ spaceship_options default_options(void)
     .ammo = -1,
     .bonus = 1000,
     .malus = -1000,
+    .layout = DEFAULT_LAYOUT,
+    .seed = 0,
+    .pregenerate = 0,
+    .world_file = NULL,
+    .large_world = false,
+    .engine = ENGINE_FUSED,
+    .ticks = 1000,
+    .script = NULL,
+    .compare_engines = false,
+    .batch = 0,
+    .threads = 0,
+    .record = NULL,
+    .replay = NULL,
+    .realtime = false,
+    .save = NULL,
+    .load = NULL,
+    .autopilot = false,
+    .population = 0,
+    .speed_curve = NULL,
   };
   return o;
 }
@@ -183,6 +282,20 @@ void check_options(
         break;
     }
   }
+
+  /* --large-world may come after --width and --height. */
+  const int max_width = o->large_world ? LARGE_MAX_WIDTH : MAX_WIDTH;
+  const int max_height = o->large_world ? LARGE_MAX_HEIGHT : MAX_HEIGHT;
+  o->width = _clamp(o->width, MIN_WIDTH, max_width);
+  o->height = _clamp(o->height, MIN_HEIGHT, max_height);
+
+  /* The autopilot copies the whole map for each of its hundreds of states. */
+  if (o->autopilot && (o->width > MAX_WIDTH || o->height > MAX_HEIGHT))
+  {
+    fprintf(stderr, "option '--autopilot' only flies maps up to %d x %d\n",
+        MAX_WIDTH, MAX_HEIGHT);
+    o->invalid = true;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -204,6 +317,41 @@ bool _parse_boolean(const char* const arg)
   return result;
 }
 
+/* "column" or "row", in any case. Returns false, leaving layout, otherwise. */
+bool _parse_layout(const char* const arg, spaceship_layout* const layout)
+{
+  if (!strcasecmp(arg, "column"))
+    *layout = LAYOUT_COLUMN_MAJOR;
+  else if (!strcasecmp(arg, "row"))
+    *layout = LAYOUT_ROW_MAJOR;
+  else
+    return false;
+  return true;
+}
+
+/* "fused" or "reference", in any case. Returns false, leaving engine, otherwise. */
+bool _parse_engine(const char* const arg, spaceship_engine* const engine)
+{
+  if (!strcasecmp(arg, "fused"))
+    *engine = ENGINE_FUSED;
+  else if (!strcasecmp(arg, "reference"))
+    *engine = ENGINE_REFERENCE;
+  else
+    return false;
+  return true;
+}
+
+void _invalid_value(spaceship_options* const o, const char* const option, const char* const arg)
+{
+  fprintf(stderr, "invalid value '%s' for option '--%s'\n", arg, option);
+  o->invalid = true;
+}
+
+int _clamp(const int value, const int min, const int max)
+{
+  return value > max ? max : value < min ? min : value;
+}
+
 void check_long_options(
     spaceship_options* const o, const int option_index, const char* const arg)
 {
@@ -217,13 +365,9 @@ void check_long_options(
       break;
     case OPTION_WIDTH:
       o->width = atoi(arg);
-      o->width = o->width > 99 ? 99 : o->width;
-      o->width = o->width < 15 ? 15 : o->width;
       break;
     case OPTION_HEIGHT:
       o->height = atoi(arg);
-      o->height = o->height > 99 ? 99 : o->height;
-      o->height = o->height < 6 ? 6 : o->height;
       break;
     case OPTION_DIFFICULTY:
       o->difficulty = atoi(arg);
@@ -245,6 +389,65 @@ void check_long_options(
       /* We should use strtoimax()... */
       o->malus = atoi(arg);
       break;
+    case OPTION_LAYOUT:
+      if (!_parse_layout(arg, &o->layout))
+        _invalid_value(o, options[option_index].name, arg);
+      break;
+    case OPTION_SEED:
+      o->seed = strtoull(arg, NULL, 0);
+      break;
+    case OPTION_PREGENERATE:
+      o->pregenerate = atoi(arg);
+      break;
+    case OPTION_WORLD_FILE:
+      o->world_file = arg;
+      break;
+    case OPTION_LARGE_WORLD:
+      o->large_world = true;
+      break;
+    case OPTION_ENGINE:
+      if (!_parse_engine(arg, &o->engine))
+        _invalid_value(o, options[option_index].name, arg);
+      break;
+    case OPTION_TICKS:
+      o->ticks = atol(arg);
+      break;
+    case OPTION_SCRIPT:
+      o->script = arg;
+      break;
+    case OPTION_COMPARE_ENGINES:
+      o->compare_engines = true;
+      break;
+    case OPTION_BATCH:
+      o->batch = atol(arg);
+      break;
+    case OPTION_THREADS:
+      o->threads = atoi(arg);
+      break;
+    case OPTION_RECORD:
+      o->record = arg;
+      break;
+    case OPTION_REPLAY:
+      o->replay = arg;
+      break;
+    case OPTION_REALTIME:
+      o->realtime = true;
+      break;
+    case OPTION_SAVE:
+      o->save = arg;
+      break;
+    case OPTION_LOAD:
+      o->load = arg;
+      break;
+    case OPTION_AUTOPILOT:
+      o->autopilot = true;
+      break;
+    case OPTION_POPULATION:
+      o->population = atol(arg);
+      break;
+    case OPTION_SPEED_CURVE:
+      o->speed_curve = arg;
+      break;
     default:
       break;
   }
@@ -21,10 +21,38 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* Without --large-world, and always with --autopilot. */
+#ifndef MAX_WIDTH
+  #define MAX_WIDTH 99
+#endif
+#ifndef MAX_HEIGHT
+  #define MAX_HEIGHT 99
+#endif
+/* Ammo cells raise the number of bullets in flight up to this. */
+#ifndef MAX_AMMO
+  #define MAX_AMMO 10
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // types
 ////////////////////////////////////////////////////////////////////////////////
 
+typedef enum spaceship_layout
+{
+  LAYOUT_COLUMN_MAJOR,
+  LAYOUT_ROW_MAJOR,
+} spaceship_layout;
+
+typedef enum spaceship_engine
+{
+  ENGINE_FUSED,
+  ENGINE_REFERENCE,
+} spaceship_engine;
+
 typedef struct spaceship_options
 {
   int height;
@@ -40,6 +68,25 @@ typedef struct spaceship_options
   int ammo;
   intmax_t bonus;
   intmax_t malus;
+  spaceship_layout layout;
+  uint64_t seed;
+  int pregenerate;
+  const char* world_file;
+  bool large_world;
+  spaceship_engine engine;
+  long ticks;
+  const char* script;
+  bool compare_engines;
+  long batch;
+  int threads;
+  const char* record;
+  const char* replay;
+  bool realtime;
+  const char* save;
+  const char* load;
+  bool autopilot;
+  long population;
+  const char* speed_curve;
 } spaceship_options;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -18,6 +18,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "node_pool.h"
+
 struct point_list
 {
 	point points;
@@ -40,32 +42,16 @@ point_list* point_list_new(void)
   return NULL;
 }
 
-// recursive //
-void point_list_destroy(point_list* const l)
-{
-  if(!l)
-    return;
-
-  point_list_destroy(l->suivant);
-  free(l);
-  return;
-}
-
-// non recursive //
-/*
 void point_list_destroy(point_list* const l)
 {
-  if(!l)
-    return;
-  
   point_list* parcours = l;
 
   while (parcours){
-    parcours = l->suivant;
-    free(l);
+    point_list* const suivant = parcours->suivant;
+    node_pool_free(parcours);
+    parcours = suivant;
   }
 }
-*/
 
 ////////////////////////////////////////////////////////////////////////////////
 // getters
@@ -116,22 +102,20 @@ bool point_list_contains(const point_list* const l, point p)
 
 point_list* point_list_push_front(point_list* const l, point p)
 {
-  point_list* const nouveau_point = malloc(sizeof(*nouveau_point));
-  //point_list* copier = l;
+  point_list* const nouveau_point = node_pool_alloc(sizeof(*nouveau_point));
   nouveau_point->precedent = NULL;
   nouveau_point->points = p;
+  nouveau_point->suivant = l;
 
   if(l)
-    nouveau_point->suivant = l;
-  else
-    nouveau_point->suivant = NULL;
+    l->precedent = nouveau_point;
 
   return nouveau_point;
 }
 
 point_list* point_list_push_back(point_list* const l, point p)
 {
-  point_list* nouveau_point = malloc(sizeof(*nouveau_point));
+  point_list* nouveau_point = node_pool_alloc(sizeof(*nouveau_point));
   nouveau_point->suivant = NULL;
   nouveau_point->points = p;
 
@@ -154,12 +138,12 @@ point_list* point_list_push_back(point_list* const l, point p)
 point_list* point_list_pop_front(point_list* const l)
 {
   if(!l->suivant){
-    free(l);
+    node_pool_free(l);
     return NULL;
   }
   else{
     point_list* dierge = l->suivant;
-    free(l);
+    node_pool_free(l);
     dierge->precedent = NULL;
     return dierge;
   }
@@ -172,8 +156,12 @@ point_list* point_list_pop_back(point_list* const l)
   while(tmp->suivant)
     tmp = point_list_suivant(tmp);
 
+  if(!tmp->precedent){
+    node_pool_free(tmp);
+    return NULL;
+  }
   tmp->precedent->suivant = NULL;
-  free(tmp);
+  node_pool_free(tmp);
   return l;
 }
 
@@ -187,47 +175,29 @@ void point_list_set_point(point_list* const l, size_t i, point p)
   tmp->points = p;
   return;
 }
-int point_longeur (point_list* const l)
-{
-	point_list* tmp = l;
-	int ll = 0;
-	while(tmp)
-	{
-    ll++;  
-    tmp = point_list_suivant(tmp);
-  }
-  return ll;
-}
-
 point_list* point_list_prune_out_of_bounds(
     point_list* const l, point up_left, point bottom_right)
 {
   point_list* tmp = l;
   point_list* dierge = tmp;
-  int ll=point_longeur(l);
   while(tmp)
   {
-     //printf("test if we need to delete a point!");
+    /* Read the next node before tmp is freed. */
+    point_list* const suivant = point_list_suivant(tmp);
     if(!point_is_in_rectangle(tmp->points, up_left, bottom_right))
     {
       if(!tmp->precedent)
-        // free(parcours);
-       { dierge = dierge->suivant;
-        point_list_pop_front(tmp); }
-      else{
-        tmp->precedent->suivant = tmp->suivant;
-        // free(parcours);
-        point_list_pop_front(tmp);
-      }
-    } 
+        dierge = suivant;
+      else
+        tmp->precedent->suivant = suivant;
+      if(suivant)
+        suivant->precedent = tmp->precedent;
+      node_pool_free(tmp);
+    }
     else if(!point_is_valid(tmp->points))
-    {	
-		//printf("valid");
-		tmp->points = point_invalid();
-
-	}
-    tmp = point_list_suivant(tmp);
-  } 
+      tmp->points = point_invalid();
+    tmp = suivant;
+  }
   if(dierge)
     return dierge;
   else
@@ -0,0 +1,480 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "population.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "bullet_array.h"
+#include "column.h"
+#include "effect.h"
+#include "prng.h"
+#include "terrain.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The map, the clock and the delays are those of world, a game of its own
+ * whose ship sits out. Everything else is one array entry per ship.
+ *
+ * The bullets of ship i are the bullet_array at bullet_memory[i * bullet_size],
+ * with its occupancy bitmap. cleared holds, per ship, one bitboard per column
+ * of the cells emptied for that ship; columns are indexed by world x modulo
+ * the width, scroll being the world x of the leftmost column. walls keeps the
+ * walls of the columns gravity may move, to see which cells it filled.
+ */
+struct population
+{
+  game* world;
+  terrain* map;
+  int width;
+  int height;
+  int difficulty;
+  effect_table effects;
+  size_t words;
+  size_t scroll;
+  size_t ships;
+  size_t alive_count;
+
+  int* x;
+  int* y;
+  bool* alive;
+  intmax_t* bonus;
+  double* lifetime;
+  size_t* bullet_max;
+  prng* random;
+
+  size_t bullet_size;
+  unsigned char* bullet_memory;
+
+  uint64_t* cleared;
+  uint64_t* walls;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static void* _alloc(size_t count, size_t size);
+static inline uint64_t* _cleared_word(const population* p, size_t i, int x, int y);
+static inline bool _is_cleared(const population* p, size_t i, int x, int y);
+static inline cell _get_cell(const population* p, size_t i, int x, int y);
+static inline bool _is_wall(const population* p, size_t i, int x, int y);
+static inline void _clear(population* p, size_t i, int x, int y);
+static inline bullet_array* _bullets(const population* p, size_t i);
+static void _scroll(population* p);
+static void _save_walls(population* p);
+static void _check_special_cells(population* p, size_t i);
+static void _check_bullets(population* p);
+static void _check_fallen(population* p);
+static void _move_bullets(population* p);
+static void _fire(population* p, size_t i);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+/* Every ship starts where a game of o would, with the same ammo. */
+population* population_new(spaceship_options o, const size_t ships)
+{
+  population* const p = malloc(sizeof *p);
+  if (!p)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  o.record = NULL;
+  p->world = game_init(o);
+  p->map = game_get_map(p->world);
+  p->width = o.width;
+  p->height = o.height;
+  p->difficulty = o.difficulty;
+  effect_table_init(&p->effects, &o);
+  p->words = column_words(o.height);
+  p->scroll = 0;
+  p->ships = ships;
+  p->alive_count = ships;
+
+  p->x = _alloc(ships, sizeof *p->x);
+  p->y = _alloc(ships, sizeof *p->y);
+  p->alive = _alloc(ships, sizeof *p->alive);
+  p->bonus = _alloc(ships, sizeof *p->bonus);
+  p->lifetime = _alloc(ships, sizeof *p->lifetime);
+  p->bullet_max = _alloc(ships, sizeof *p->bullet_max);
+  p->random = _alloc(ships, sizeof *p->random);
+
+  const size_t ammo = game_get_max_ammo(p->world);
+  const size_t capacity = ammo > MAX_AMMO ? ammo : MAX_AMMO;
+  p->bullet_size = bullet_array_footprint(capacity, p->width, p->height);
+  p->bullet_memory = _alloc(ships, p->bullet_size);
+
+  p->cleared = _alloc(ships * (size_t) p->width * p->words, sizeof *p->cleared);
+  p->walls = _alloc((size_t) p->width * p->words, sizeof *p->walls);
+
+  const point start = game_get_ship_position(p->world);
+  for (size_t i = 0; i < ships; ++i)
+  {
+    p->x[i] = start.x;
+    p->y[i] = start.y;
+    p->alive[i] = true;
+    p->bullet_max[i] = ammo;
+    bullet_array_init(p->bullet_memory + i * p->bullet_size, capacity, p->width, p->height);
+    /* Ship 0 draws the secret cells of a single game. */
+    prng_seed(p->random + i, ~o.seed ^ i);
+  }
+
+  return p;
+}
+
+void population_destroy(population* const p)
+{
+  if (!p)
+    return;
+
+  game_destroy(p->world);
+  free(p->x);
+  free(p->y);
+  free(p->alive);
+  free(p->bonus);
+  free(p->lifetime);
+  free(p->bullet_max);
+  free(p->random);
+  free(p->bullet_memory);
+  free(p->cleared);
+  free(p->walls);
+  free(p);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+size_t population_get_size(const population* const p)
+{
+  return p->ships;
+}
+
+size_t population_get_alive(const population* const p)
+{
+  return p->alive_count;
+}
+
+bool population_ship_is_alive(const population* const p, const size_t i)
+{
+  return p->alive[i];
+}
+
+point population_get_ship_position(const population* const p, const size_t i)
+{
+  return point_xy(p->x[i], p->y[i]);
+}
+
+/* As game_get_score(), the clock of a dead ship stopped with it. */
+intmax_t population_get_score(const population* const p, const size_t i)
+{
+  const double elapsed = p->alive[i]
+      ? game_get_elapsed_time(p->world) : p->lifetime[i];
+  return p->bonus[i] + (intmax_t) elapsed * 10;
+}
+
+/* For the options and the map. */
+const game* population_get_world(const population* const p)
+{
+  return p->world;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void population_set_elapsed_time(population* const p, const double t)
+{
+  game_set_elapsed_time(p->world, t);
+}
+
+/* The keys of game_process_input(), for ship i. */
+void population_process_input(population* const p, const size_t i, const int key)
+{
+  if (!p->alive[i])
+    return;
+
+  const bool vim = p->difficulty >= 2;
+  const int x = p->x[i];
+  const int y = p->y[i];
+  switch (key)
+  {
+    case '8':
+    case 'k':
+    case 65:
+      if ((!vim || key == 'k') && y > 0 && !_is_wall(p, i, x, y - 1))
+        --p->y[i];
+      break;
+    case '2':
+    case 'j':
+    case 66:
+      if ((!vim || key == 'j') && y < p->height - 1 && !_is_wall(p, i, x, y + 1))
+        ++p->y[i];
+      break;
+    case '4':
+    case 'h':
+    case 68:
+      /* Without scrolling, difficulty 0 keeps the ship off the left edge. */
+      if ((!vim || key == 'h') && x > (p->difficulty <= 0 ? 1 : 0)
+          && !_is_wall(p, i, x - 1, y))
+        --p->x[i];
+      break;
+    case '6':
+    case 'l':
+    case 67:
+      if ((!vim || key == 'l') && x < p->width - 2 && !_is_wall(p, i, x + 1, y))
+        ++p->x[i];
+      break;
+    case ' ':
+      _fire(p, i);
+      break;
+    default:
+      break;
+  }
+  _check_special_cells(p, i);
+}
+
+/*
+ * game_compute_turn_reference() for every living ship, the map being
+ * scrolled and fallen once for all of them. The bullets of all the ships are
+ * checked in one pass, and after gravity only in the columns that moved.
+ */
+void population_compute_turn(population* const p)
+{
+  for (size_t i = 0; i < p->ships; ++i)
+    if (p->alive[i])
+      _check_special_cells(p, i);
+  _check_bullets(p);
+
+  terrain_right(p->map);
+  _scroll(p);
+
+  _check_bullets(p);
+  _move_bullets(p);
+  _check_bullets(p);
+
+  _save_walls(p);
+  terrain_fall(p->map);
+  _check_fallen(p);
+
+  const double elapsed = game_get_elapsed_time(p->world);
+  for (size_t i = 0; i < p->ships; ++i)
+  {
+    if (!p->alive[i])
+      continue;
+    _check_special_cells(p, i);
+    if (_is_wall(p, i, p->x[i], p->y[i]))
+    {
+      p->alive[i] = false;
+      p->lifetime[i] = elapsed;
+      --p->alive_count;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+void* _alloc(const size_t count, const size_t size)
+{
+  void* const memory = calloc(count ? count : 1, size);
+  if (!memory)
+  {
+    perror("calloc");
+    exit(EX_OSERR);
+  }
+  return memory;
+}
+
+/* Word of the cleared cells of ship i holding (x, y) of the map. */
+uint64_t* _cleared_word(const population* const p, const size_t i, const int x, const int y)
+{
+  const size_t slot = (p->scroll + (size_t) x) % (size_t) p->width;
+  return p->cleared + (i * (size_t) p->width + slot) * p->words
+      + (size_t) y / COLUMN_WORD_BITS;
+}
+
+bool _is_cleared(const population* const p, const size_t i, const int x, const int y)
+{
+  return *_cleared_word(p, i, x, y) >> ((size_t) y % COLUMN_WORD_BITS) & 1;
+}
+
+cell _get_cell(const population* const p, const size_t i, const int x, const int y)
+{
+  return _is_cleared(p, i, x, y)
+      ? CELL_EMPTY : terrain_get_cell(p->map, (size_t) x, (size_t) y);
+}
+
+bool _is_wall(const population* const p, const size_t i, const int x, const int y)
+{
+  return terrain_is_wall(p->map, (size_t) x, (size_t) y) && !_is_cleared(p, i, x, y);
+}
+
+void _clear(population* const p, const size_t i, const int x, const int y)
+{
+  *_cleared_word(p, i, x, y) |= UINT64_C(1) << ((size_t) y % COLUMN_WORD_BITS);
+}
+
+bullet_array* _bullets(const population* const p, const size_t i)
+{
+  return (bullet_array*) (p->bullet_memory + i * p->bullet_size);
+}
+
+/*
+ * After terrain_right(): the slot of the column that left on the left is the
+ * one of the new rightmost column, which nobody has touched yet.
+ */
+void _scroll(population* const p)
+{
+  const size_t slot = p->scroll % (size_t) p->width;
+  for (size_t i = 0; i < p->ships; ++i)
+    memset(p->cleared + (i * (size_t) p->width + slot) * p->words, 0,
+        sizeof *p->cleared * p->words);
+  ++p->scroll;
+}
+
+/* Before terrain_fall(): the walls of the columns it may move. */
+void _save_walls(population* const p)
+{
+  const size_t width = (size_t) p->width;
+  for (size_t x = terrain_next_dirty(p->map, 0); x < width;
+      x = terrain_next_dirty(p->map, x + 1))
+  {
+    const column* const c = terrain_get_column(p->map, x);
+    for (size_t w = 0; w < p->words; ++w)
+      p->walls[x * p->words + w] = column_walls(c, w);
+  }
+}
+
+/* game_check_special_cells(), the used cell being cleared for ship i. */
+void _check_special_cells(population* const p, const size_t i)
+{
+  const int x = p->x[i];
+  const int y = p->y[i];
+  const effect_target target = { .bonus = p->bonus + i, .bullet_max = p->bullet_max + i, };
+  if (effect_apply(&p->effects, _get_cell(p, i, x, y), p->random + i, target))
+    _clear(p, i, x, y);
+}
+
+/*
+ * Drop the bullets that hit something or left the map, for every living
+ * ship. The bullets of a ship are sorted by x: each column holding some is
+ * tested a word at a time, against the cells of the map not cleared for it.
+ */
+void _check_bullets(population* const p)
+{
+  const point up_left = { .x = 0, .y = 0, };
+  const point bottom_right = { .x = p->width, .y = p->height, };
+  for (size_t i = 0; i < p->ships; ++i)
+  {
+    bullet_array* const b = _bullets(p, i);
+    if (!p->alive[i] || !bullet_array_get_size(b))
+      continue;
+
+    int last = p->width;
+    for (size_t k = 0; k < bullet_array_get_size(b); ++k)
+    {
+      const int x = bullet_array_get_point(b, k).x;
+      if (x == last || x < 0 || x >= p->width)
+        continue;
+      last = x;
+
+      const column* const c = terrain_get_column(p->map, (size_t) x);
+      for (size_t w = 0; w < p->words; ++w)
+      {
+        const int y = (int) (w * COLUMN_WORD_BITS);
+        uint64_t* const cleared = _cleared_word(p, i, x, y);
+        const uint64_t hits =
+            bullet_array_occupied(b, x, w) & column_occupied(c, w) & ~*cleared;
+        *cleared |= hits;
+        for (uint64_t h = hits; h; h &= h - 1)
+          bullet_array_kill_at(b, point_xy(x, y + __builtin_ctzll(h)));
+      }
+    }
+    bullet_array_prune(b, up_left, bottom_right);
+  }
+}
+
+/*
+ * After terrain_fall(): a wall that fell into a cell cleared for a ship is
+ * there for that ship too, and only the columns that moved can hold a new
+ * hit. Each of them is loaded once for all the ships.
+ */
+void _check_fallen(population* const p)
+{
+  const point up_left = { .x = 0, .y = 0, };
+  const point bottom_right = { .x = p->width, .y = p->height, };
+  const size_t width = (size_t) p->width;
+  bool hit = false;
+  for (size_t x = terrain_next_dirty(p->map, 0); x < width;
+      x = terrain_next_dirty(p->map, x + 1))
+  {
+    const column* const c = terrain_get_column(p->map, x);
+    for (size_t w = 0; w < p->words; ++w)
+    {
+      const int y = (int) (w * COLUMN_WORD_BITS);
+      const uint64_t filled = column_walls(c, w) & ~p->walls[x * p->words + w];
+      const uint64_t occupied = column_occupied(c, w);
+      for (size_t i = 0; i < p->ships; ++i)
+      {
+        uint64_t* const cleared = _cleared_word(p, i, (int) x, y);
+        *cleared &= ~filled;
+        if (!p->alive[i])
+          continue;
+
+        bullet_array* const b = _bullets(p, i);
+        const uint64_t hits = bullet_array_occupied(b, (int) x, w) & occupied & ~*cleared;
+        *cleared |= hits;
+        for (uint64_t h = hits; h; h &= h - 1)
+          bullet_array_kill_at(b, point_xy((int) x, y + __builtin_ctzll(h)));
+        hit |= hits != 0;
+      }
+    }
+  }
+
+  if (hit)
+    for (size_t i = 0; i < p->ships; ++i)
+      bullet_array_prune(_bullets(p, i), up_left, bottom_right);
+}
+
+/* Every bullet of every ship moves one column to the right. */
+void _move_bullets(population* const p)
+{
+  for (size_t i = 0; i < p->ships; ++i)
+    bullet_array_shift(_bullets(p, i), 1);
+}
+
+void _fire(population* const p, const size_t i)
+{
+  bullet_array* const b = _bullets(p, i);
+  const size_t fired = bullet_array_get_size(b);
+  const point bullet = point_xy(p->x[i] + 1, p->y[i]);
+  if (fired >= p->bullet_max[i] || bullet_array_contains(b, bullet))
+    return;
+
+  bullet_array_push(b, bullet);
+  p->bonus[i] -= 20 * (intmax_t) ((fired + 1) * (fired + 1));
+}
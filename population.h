@@ -0,0 +1,69 @@
+#ifndef _POPULATION_H_
+#define _POPULATION_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "point.h"
+#include "game.h"
+#include "options.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Ships flying over the same map, each with its own keys, bullets and score.
+ * The map scrolls and falls once per turn for all of them.
+ *
+ * Sharing the map changes the rules a little: a ship never scrolls it (it
+ * stops at the edges instead), and the cells a ship empties, by shooting or
+ * picking them up, are only empty for that ship and don't make the rest of
+ * the column fall. A wall that falls into one of them fills it again.
+ */
+typedef struct population population;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+population* population_new(spaceship_options o, size_t ships);
+void population_destroy(population* p);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+size_t population_get_size(const population* p);
+size_t population_get_alive(const population* p);
+bool population_ship_is_alive(const population* p, size_t i);
+point population_get_ship_position(const population* p, size_t i);
+intmax_t population_get_score(const population* p, size_t i);
+const game* population_get_world(const population* p);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void population_set_elapsed_time(population* p, double t);
+void population_process_input(population* p, size_t i, int key);
+void population_compute_turn(population* p);
+
+#endif
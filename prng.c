@@ -0,0 +1,106 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "prng.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t _rotl(uint64_t x, unsigned k);
+static inline uint64_t _splitmix64(uint64_t* x);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+void prng_seed(prng* const r, const uint64_t seed)
+{
+  /* The state must not be all zeros, splitmix64 takes care of that. */
+  uint64_t x = seed;
+  for (size_t i = 0; i < 4; ++i)
+    r->state[i] = _splitmix64(&x);
+  r->next = PRNG_BLOCK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+/* One step of splitmix64 from x: a cheap 64-bit hash, bijective. */
+uint64_t prng_mix(uint64_t x)
+{
+  return _splitmix64(&x);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t prng_next(prng* const r)
+{
+  if (r->next == PRNG_BLOCK)
+  {
+    prng_fill(r, r->block, PRNG_BLOCK);
+    r->next = 0;
+  }
+  return r->block[r->next++];
+}
+
+/* Same range as random(): [0, 2^31). */
+long prng_random(prng* const r)
+{
+  return (long) (prng_next(r) >> 33);
+}
+
+void prng_fill(prng* const r, uint64_t* const out, const size_t n)
+{
+  uint64_t s0 = r->state[0];
+  uint64_t s1 = r->state[1];
+  uint64_t s2 = r->state[2];
+  uint64_t s3 = r->state[3];
+  for (size_t i = 0; i < n; ++i)
+  {
+    out[i] = _rotl(s1 * 5, 7) * 9;
+    const uint64_t t = s1 << 17;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = _rotl(s3, 45);
+  }
+  r->state[0] = s0;
+  r->state[1] = s1;
+  r->state[2] = s2;
+  r->state[3] = s3;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t _rotl(const uint64_t x, const unsigned k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+uint64_t _splitmix64(uint64_t* const x)
+{
+  uint64_t z = (*x += UINT64_C(0x9e3779b97f4a7c15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
@@ -0,0 +1,67 @@
+#ifndef _PRNG_H_
+#define _PRNG_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+#include <inttypes.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PRNG_BLOCK
+  #define PRNG_BLOCK 32
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * xoshiro256** generator. Numbers are produced PRNG_BLOCK at a time into
+ * block and handed out from there, the state is plain data so a generator can
+ * be copied by value.
+ */
+typedef struct prng
+{
+  uint64_t state[4];
+  uint64_t block[PRNG_BLOCK];
+  size_t next;
+} prng;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+void prng_seed(prng* r, uint64_t seed);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t prng_mix(uint64_t x);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t prng_next(prng* r);
+long prng_random(prng* r);
+void prng_fill(prng* r, uint64_t* out, size_t n);
+
+#endif
@@ -0,0 +1,265 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "recording.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+#define RECORDING_MAGIC "SSIR"
+#define RECORDING_VERSION 1
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+struct recorder
+{
+  FILE* file;
+  const char* path;
+  uint64_t last;
+};
+
+struct replay
+{
+  FILE* file;
+  const char* path;
+  uint64_t last;
+  bool done;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static void _put(recorder* r, uint64_t value);
+static inline void _put_signed(recorder* r, int64_t value);
+static void _event(recorder* r, recording_kind kind, double elapsed);
+static uint64_t _get(replay* r);
+static inline int64_t _get_signed(replay* r);
+static inline uint64_t _milliseconds(double elapsed);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+recorder* recorder_create(const char* const path, const spaceship_options* const o)
+{
+  recorder* const r = malloc(sizeof *r);
+  if (!r)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  r->file = fopen(path, "wb");
+  if (!r->file)
+  {
+    perror(path);
+    exit(EX_CANTCREAT);
+  }
+  r->path = path;
+  r->last = 0;
+
+  uint64_t delay;
+  memcpy(&delay, &o->constant_delay, sizeof delay);
+
+  fputs(RECORDING_MAGIC, r->file);
+  fputc(RECORDING_VERSION, r->file);
+  _put(r, o->seed);
+  _put_signed(r, o->height);
+  _put_signed(r, o->width);
+  _put_signed(r, o->difficulty);
+  _put_signed(r, o->ammo);
+  _put_signed(r, o->bonus);
+  _put_signed(r, o->malus);
+  _put(r, delay);
+  _put(r, (uint64_t) o->still | (uint64_t) o->large_world << 1);
+  _put(r, (uint64_t) o->layout);
+  _put(r, (uint64_t) o->engine);
+
+  return r;
+}
+
+void recorder_close(recorder* const r, const double elapsed)
+{
+  if (!r)
+    return;
+
+  _event(r, RECORDING_END, elapsed);
+  if (fclose(r->file))
+    perror(r->path);
+  free(r);
+}
+
+/* The options read from the file replace the ones of the command line. */
+replay* replay_open(const char* const path, spaceship_options* const o)
+{
+  replay* const r = malloc(sizeof *r);
+  if (!r)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  r->file = fopen(path, "rb");
+  if (!r->file)
+  {
+    perror(path);
+    exit(EX_NOINPUT);
+  }
+  r->path = path;
+  r->last = 0;
+  r->done = false;
+
+  char magic[sizeof RECORDING_MAGIC] = { 0 };
+  if (fread(magic, 1, sizeof magic - 1, r->file) != sizeof magic - 1
+      || strcmp(magic, RECORDING_MAGIC) || fgetc(r->file) != RECORDING_VERSION)
+  {
+    fprintf(stderr, "%s: not a recording or unknown version.\n", path);
+    exit(EX_DATAERR);
+  }
+
+  o->seed = _get(r);
+  o->height = (int) _get_signed(r);
+  o->width = (int) _get_signed(r);
+  o->difficulty = (int) _get_signed(r);
+  o->ammo = (int) _get_signed(r);
+  o->bonus = _get_signed(r);
+  o->malus = _get_signed(r);
+  const uint64_t delay = _get(r);
+  memcpy(&o->constant_delay, &delay, sizeof delay);
+  const uint64_t flags = _get(r);
+  o->still = flags & 1;
+  o->large_world = flags >> 1 & 1;
+  const uint64_t layout = _get(r);
+  const uint64_t engine = _get(r);
+  o->layout = (spaceship_layout) layout;
+  o->engine = (spaceship_engine) engine;
+
+  return r;
+}
+
+void replay_close(replay* const r)
+{
+  if (!r)
+    return;
+
+  fclose(r->file);
+  free(r);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+/* Returns false after the RECORDING_END event. */
+bool replay_next(replay* const r, recording_event* const e)
+{
+  if (r->done)
+    return false;
+
+  const uint64_t header = _get(r);
+  r->last += header >> 2;
+  e->kind = (recording_kind) (header & 3);
+  e->elapsed = (double) r->last / 1000.0;
+  e->key = e->kind == RECORDING_KEY ? (int) _get_signed(r) : 0;
+  r->done = e->kind == RECORDING_END;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void recorder_key(recorder* const r, const double elapsed, const int key)
+{
+  _event(r, RECORDING_KEY, elapsed);
+  _put_signed(r, key);
+}
+
+void recorder_turn(recorder* const r, const double elapsed)
+{
+  _event(r, RECORDING_TURN, elapsed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+void _put(recorder* const r, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    fputc((int) (value & 0x7f) | 0x80, r->file);
+    value >>= 7;
+  }
+  if (fputc((int) value, r->file) == EOF)
+  {
+    perror(r->path);
+    exit(EX_IOERR);
+  }
+}
+
+void _put_signed(recorder* const r, const int64_t value)
+{
+  _put(r, (uint64_t) value << 1 ^ (uint64_t) (value >> 63));
+}
+
+/* Times only go forward: a clock going back counts as no time at all. */
+void _event(recorder* const r, const recording_kind kind, const double elapsed)
+{
+  uint64_t now = _milliseconds(elapsed);
+  now = now < r->last ? r->last : now;
+  _put(r, (now - r->last) << 2 | kind);
+  r->last = now;
+}
+
+uint64_t _get(replay* const r)
+{
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7)
+  {
+    const int byte = fgetc(r->file);
+    if (byte == EOF)
+    {
+      fprintf(stderr, "%s: truncated recording.\n", r->path);
+      exit(EX_DATAERR);
+    }
+    value |= (uint64_t) (byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  fprintf(stderr, "%s: corrupted recording.\n", r->path);
+  exit(EX_DATAERR);
+}
+
+int64_t _get_signed(replay* const r)
+{
+  const uint64_t value = _get(r);
+  return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+uint64_t _milliseconds(const double elapsed)
+{
+  return elapsed > 0.0 ? (uint64_t) (elapsed * 1000.0) : 0;
+}
@@ -0,0 +1,77 @@
+#ifndef _RECORDING_H_
+#define _RECORDING_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stdbool.h>
+#include "options.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A recording is the seed and the options that the rules depend on, then
+ * every key given to game_process_input() and every game_compute_turn(),
+ * stamped with the elapsed time in milliseconds, and the final elapsed time.
+ *
+ * The file starts with RECORDING_MAGIC and a version byte. All the numbers
+ * are LEB128 varints, signed ones zigzag-encoded first. An event is
+ * varint(milliseconds since the previous event << 2 | kind), followed by
+ * varint(key) for keys.
+ */
+typedef enum recording_kind
+{
+  RECORDING_KEY,
+  RECORDING_TURN,
+  RECORDING_END,
+} recording_kind;
+
+typedef struct recording_event
+{
+  recording_kind kind;
+  double elapsed;
+  int key;
+} recording_event;
+
+typedef struct recorder recorder;
+typedef struct replay replay;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+recorder* recorder_create(const char* path, const spaceship_options* o);
+void recorder_close(recorder* r, double elapsed);
+
+replay* replay_open(const char* path, spaceship_options* o);
+void replay_close(replay* r);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+bool replay_next(replay* r, recording_event* e);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void recorder_key(recorder* r, double elapsed, int key);
+void recorder_turn(recorder* r, double elapsed);
+
+#endif
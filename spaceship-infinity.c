@@ -57,14 +57,18 @@ int main(int argc, char* argv[static argc + 1])
   if (o.invalid)
     return EX_USAGE;
 
-  srandom((unsigned int) (time(NULL) + getpid()));
+  if (!o.seed)
+    o.seed = (uint64_t) time(NULL) + (uint64_t) getpid();
   setlocale(LC_CTYPE, "");
-  interface* const ui = interface_init(o);
-  game* const g = game_init(o);
+  game* const g = o.load ? game_load(o.load, o) : game_init(o);
+  interface* const ui = interface_init(game_get_options(g));
 
   interface_display(ui, g);
   interface_game_loop(ui, g);
 
+  /* A game over has nothing left to resume. */
+  if (o.save && game_ship_is_alive(g))
+    game_save(g, o.save);
   game_destroy(g);
   interface_destroy(ui);
 
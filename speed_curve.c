@@ -0,0 +1,299 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "speed_curve.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct speed_point
+{
+  double time;
+  double delay;
+} speed_point;
+
+/*
+ * Line k goes from points[k] to points[k + 1]. lines[i] is the first line
+ * that ends in entry i, elapsed / step, or later: the one for an elapsed time
+ * in that entry, or a few before it when several points fall into it.
+ */
+struct speed_curve
+{
+  speed_point* points;
+  size_t count;
+  uint32_t* lines;
+  size_t entries;
+  double step;
+};
+
+/* The curves of the difficulties: 1 - elapsed / divisor, then after. */
+typedef struct speed_ramp
+{
+  double end;
+  double divisor;
+  double after;
+} speed_ramp;
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static speed_curve* _new(speed_point* points, size_t count);
+static speed_curve* _ramp(speed_ramp r);
+static char* _read_file(const char* path);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The curve of o: a --constant-delay, else the points of --speed-curve (a
+ * file holding them, or the points themselves), else the curve of the
+ * difficulty.
+ */
+speed_curve* speed_curve_new(const spaceship_options* const o)
+{
+  if (o->constant_delay > 0.0)
+  {
+    speed_point* const point = malloc(sizeof *point);
+    if (!point)
+    {
+      perror("malloc");
+      exit(EX_OSERR);
+    }
+    *point = (speed_point) { .time = 0.0, .delay = o->constant_delay, };
+    return _new(point, 1);
+  }
+
+  if (o->speed_curve)
+  {
+    char* const text = _read_file(o->speed_curve);
+    speed_curve* const c = speed_curve_parse(text ? text : o->speed_curve);
+    free(text);
+    return c;
+  }
+
+  switch (o->difficulty)
+  {
+    case 0:
+      return _ramp((speed_ramp) { .end = 59.0, .divisor = 60.0, .after = 0.3, });
+    case 1:
+      return _ramp((speed_ramp) { .end = 30.0, .divisor = 45.0, .after = 0.25, });
+    default:
+      return _ramp((speed_ramp) { .end = 14.0, .divisor = 15.0, .after = 0.15, });
+  }
+}
+
+/*
+ * Read "<seconds>:<delay>" points separated by commas or blanks, in order of
+ * time; '#' starts a comment up to the end of the line.
+ */
+speed_curve* speed_curve_parse(const char* points)
+{
+  size_t count = 0;
+  size_t capacity = 8;
+  speed_point* p = malloc(sizeof *p * capacity);
+  if (!p)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  for (const char* s = points; *s; )
+  {
+    if (isspace((unsigned char) *s) || *s == ',')
+    {
+      ++s;
+      continue;
+    }
+    if (*s == '#')
+    {
+      s += strcspn(s, "\n");
+      continue;
+    }
+
+    char* end = NULL;
+    const double time = strtod(s, &end);
+    const bool colon = end != s && *end == ':';
+    const char* const delay_start = colon ? end + 1 : end;
+    const double delay = colon ? strtod(delay_start, &end) : 0.0;
+    if (!colon || end == delay_start
+        || (*end && !isspace((unsigned char) *end) && *end != ',' && *end != '#'))
+    {
+      fprintf(stderr, "speed curve: expected <seconds>:<delay> at \"%.20s\".\n", s);
+      exit(EX_DATAERR);
+    }
+    if (!isfinite(time) || !isfinite(delay) || time < 0.0 || delay <= 0.0
+        || (count && time < p[count - 1].time))
+    {
+      fprintf(stderr, "speed curve: bad point %g:%g (times go up from 0, "
+          "delays are positive, both finite).\n", time, delay);
+      exit(EX_DATAERR);
+    }
+
+    if (count == capacity)
+    {
+      capacity *= 2;
+      speed_point* const grown = realloc(p, sizeof *p * capacity);
+      if (!grown)
+      {
+        perror("realloc");
+        exit(EX_OSERR);
+      }
+      p = grown;
+    }
+    p[count++] = (speed_point) { .time = time, .delay = delay, };
+    s = end;
+  }
+
+  if (!count)
+  {
+    fprintf(stderr, "speed curve: no points.\n");
+    exit(EX_DATAERR);
+  }
+  return _new(p, count);
+}
+
+void speed_curve_destroy(speed_curve* const c)
+{
+  if (!c)
+    return;
+
+  free(c->points);
+  free(c->lines);
+  free(c);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+/* Delay between two turns after elapsed seconds of play. */
+double speed_curve_delay(const speed_curve* const c, const double elapsed)
+{
+  const speed_point* const p = c->points;
+  if (elapsed <= p[0].time)
+    return p[0].delay;
+  if (elapsed > p[c->count - 1].time)
+    return p[c->count - 1].delay;
+
+  size_t k = c->lines[(size_t) (elapsed / c->step)];
+  while (elapsed > p[k + 1].time)
+    ++k;
+  return p[k].delay + (p[k + 1].delay - p[k].delay)
+      * ((elapsed - p[k].time) / (p[k + 1].time - p[k].time));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* Take points and build the lookup table. */
+speed_curve* _new(speed_point* const points, const size_t count)
+{
+  speed_curve* const c = malloc(sizeof *c);
+  if (!c)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  const double last = points[count - 1].time;
+  c->points = points;
+  c->count = count;
+  c->step = last / SPEED_CURVE_STEP < SPEED_CURVE_ENTRIES - 1
+      ? SPEED_CURVE_STEP : last / (SPEED_CURVE_ENTRIES - 1);
+  c->entries = (size_t) (last / c->step) + 1;
+  c->lines = malloc(sizeof *c->lines * c->entries);
+  if (!c->lines)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  /* Entries are found as speed_curve_delay() does, so no rounding skips a line. */
+  size_t k = 0;
+  for (size_t i = 0; i < c->entries; ++i)
+  {
+    while (k + 2 < count && (size_t) (points[k + 1].time / c->step) < i)
+      ++k;
+    c->lines[i] = (uint32_t) k;
+  }
+  return c;
+}
+
+/* From 1 down the line 1 - elapsed / divisor until end, then flat at after. */
+speed_curve* _ramp(const speed_ramp r)
+{
+  speed_point* const points = malloc(sizeof *points * 3);
+  if (!points)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  points[0] = (speed_point) { .time = 0.0, .delay = 1.0, };
+  points[1] = (speed_point) { .time = r.end, .delay = 1.0 - r.end / r.divisor, };
+  points[2] = (speed_point) { .time = r.end, .delay = r.after, };
+  return _new(points, 3);
+}
+
+/* The whole file at path, or NULL when there is no such file. */
+char* _read_file(const char* const path)
+{
+  FILE* const file = fopen(path, "r");
+  if (!file)
+    return NULL;
+
+  size_t size = 0;
+  size_t capacity = 256;
+  char* text = malloc(capacity);
+  if (!text)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  for (size_t n; (n = fread(text + size, 1, capacity - size - 1, file)) > 0; )
+  {
+    size += n;
+    if (size + 1 == capacity)
+    {
+      capacity *= 2;
+      char* const grown = realloc(text, capacity);
+      if (!grown)
+      {
+        perror("realloc");
+        exit(EX_OSERR);
+      }
+      text = grown;
+    }
+  }
+  if (ferror(file))
+  {
+    perror(path);
+    exit(EX_IOERR);
+  }
+  fclose(file);
+  text[size] = '\0';
+  return text;
+}
@@ -0,0 +1,63 @@
+#ifndef _SPEED_CURVE_H_
+#define _SPEED_CURVE_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include "options.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* Seconds of play per entry of the lookup table, and most entries. */
+#ifndef SPEED_CURVE_STEP
+  #define SPEED_CURVE_STEP 0.125
+#endif
+#ifndef SPEED_CURVE_ENTRIES
+  #define SPEED_CURVE_ENTRIES 65536
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The delay between two turns as a function of the seconds played: straight
+ * lines through a list of "<seconds>:<delay>" points, flat before the first
+ * and after the last. Two points at the same time make a jump, the curve
+ * taking the second value just after that time.
+ *
+ * A lookup table gives the line for each SPEED_CURVE_STEP of play, so a
+ * delay costs one division and one interpolation.
+ */
+typedef struct speed_curve speed_curve;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+speed_curve* speed_curve_new(const spaceship_options* o);
+speed_curve* speed_curve_parse(const char* points);
+void speed_curve_destroy(speed_curve* c);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+double speed_curve_delay(const speed_curve* c, double elapsed);
+
+#endif
@@ -17,8 +17,27 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tgmath.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
 #include <sysexits.h>
+#include <sys/mman.h>
+
+#include "column_queue.h"
+#include "world_store.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Build with -DTERRAIN_CHECK_FALL to check every vectorized terrain_fall()
+ * against column_fall() on a copy of the grid.
+ */
 
 ////////////////////////////////////////////////////////////////////////////////
 // types
@@ -26,67 +45,256 @@
 
 struct terrain
 {
-  column_list* columns;
+  /*
+   * All the bitboards live in one aligned block, laid out column by column or
+   * word row by word row. views[k] is the column stored in the k-th slot of
+   * the grid.
+   *
+   * The views, dirty, hashes and grid follow the structure in the memory
+   * given to terrain_init(), grid last, so a terrain moves with one memcpy()
+   * and terrain_rebase(). Only a grid mapped by terrain_load() lives outside.
+   *
+   * The slots form a circular array: the leftmost column lives at index head
+   * and the map wraps around, so scrolling only moves head.
+   */
+  uint64_t* grid;
+  size_t mapped;
+  column* views;
+  size_t words;
+  size_t head;
+  /*
+   * One bit per slot: the columns that may still fall. Settled columns only
+   * become dirty again when they are generated or one of their cells is set.
+   */
+  uint64_t* dirty;
+  size_t fall_count;
+  /*
+   * hashes[k] is the column_hash() of slot k keyed by its world x, hash the
+   * XOR of them all. Both follow every change to the grid.
+   */
+  uint64_t* hashes;
+  uint64_t hash;
+  spaceship_layout layout;
   int height;
   int width;
   int genLow;
   int genHigh;
   int difficulty;
+  prng random;
+  /*
+   * origin is the world x of the leftmost column. With difficulty 0, the
+   * columns scrolled off either side go to store and come back from it.
+   */
+  world_store* store;
+  long origin;
+  /*
+   * New columns draw from generator, random itself unless a producer thread
+   * is running: with --pregenerate, it fills queue with the next columns to
+   * the right from a copy of random of its own. Each column taken from the
+   * queue brings along the generator that follows it, so random always
+   * stands right after the map, as without a producer.
+   */
+  prng* generator;
+  column_queue* queue;
+  pthread_t producer;
+  atomic_bool stop;
 };
 
+/*
+ * Fixed part of a saved terrain. It is followed by the generator, the dirty
+ * bitset, the column hashes, then the grid itself at grid_offset. Columns
+ * generated ahead are not saved: the generator makes them again.
+ */
+typedef struct terrain_record
+{
+  uint64_t head;
+  int64_t origin;
+  int64_t gen_low;
+  int64_t gen_high;
+  uint64_t fall_count;
+  uint64_t hash;
+  uint64_t grid_offset;
+  uint64_t grid_size;
+} terrain_record;
+
 ////////////////////////////////////////////////////////////////////////////////
 // local function declarations
 ////////////////////////////////////////////////////////////////////////////////
 
+static inline size_t _slot(const terrain* t, size_t x);
+static inline void _mark_dirty(terrain* t, size_t slot);
+static inline uint64_t _key(const terrain* t, size_t slot);
+static void _rehash(terrain* t, size_t slot);
+static void _load_column(terrain* t, size_t slot, const column* c);
+static void _step_generator(terrain* t, bool forward);
+static terrain* _new(void* memory, spaceship_options o);
+static void _place(terrain* t);
+static void _start_producer(terrain* t);
+static void _stop_producer(terrain* t);
+static void* _produce(void* arg);
+static void _read(FILE* file, void* data, size_t size);
+static void _write(FILE* file, const void* data, size_t size);
+static inline size_t _grid_size(size_t words, int width);
+static inline size_t _grid_offset(int width);
+#ifdef TERRAIN_CHECK_FALL
+static void _check_fall(const terrain* t, const uint64_t* before);
+#endif
 static inline int _trig_low(int genLow, double hmin);
 static inline int _trig_high(int genHigh, double height);
-static inline column* _trig_column(int genLow, int genHigh, int height);
-static inline int _random_generation_selection(int difficulty);
-static column* _random_column(int height, int difficulty);
-static column* terrain_new_column(terrain* t, bool forward);
+static inline void _trig_column(column* c, int genLow, int genHigh);
+static inline int _random_generation_selection(terrain* t);
+static void _random_column(terrain* t, column* c);
+static void terrain_new_column(terrain* t, column* c, bool forward);
 
 ////////////////////////////////////////////////////////////////////////////////
 // init./destroy etc.
 ////////////////////////////////////////////////////////////////////////////////
 
-terrain* terrain_init(const int height, const int width, const int difficulty)
+/* Bytes of memory terrain_init() and terrain_load() need for o. */
+size_t terrain_footprint(const spaceship_options o)
 {
-  terrain* const t = malloc(sizeof *t);
-  if (!t)
-  {
-    perror("malloc");
-    exit(EX_OSERR);
-  }
+  const size_t words = COLUMN_PLANES * column_words(o.height);
+  return _grid_offset(o.width) + _grid_size(words, o.width);
+}
 
+/*
+ * Build the terrain in memory, terrain_footprint() bytes aligned on
+ * TERRAIN_ALIGNMENT. The caller frees it after terrain_destroy().
+ */
+terrain* terrain_init(void* const memory, const spaceship_options o)
+{
+  const int height = o.height;
+  const int width = o.width;
+  const int difficulty = o.difficulty;
 
-  t->height = height;
-  t->width = width;
-  t->difficulty = difficulty;
-  t->genLow = 0;
-  t->genHigh = 0;
+  terrain* const t = _new(memory, o);
+  prng_seed(&t->random, o.seed);
 
-  t->columns = column_list_new();
+  /* Columns are generated from right to left. */
   for (int k = 0; k < width; ++k)
   {
-    column* c = NULL;
+    column* const c = t->views + (width - 1 - k);
     if (difficulty != 0 && k > (width - 10))
-      c = column_new(height, 0, height - 1);
+      column_reset(c, 0, height - 1);
     else
-      c = terrain_new_column(t, true);
-    t->columns = column_list_push_front(t->columns, c);
+    {
+      terrain_new_column(t, c, true);
+      _mark_dirty(t, (size_t) (width - 1 - k));
+    }
+  }
+  for (size_t k = 0; k < (size_t) width; ++k)
+    _rehash(t, k);
+
+  if (difficulty <= 0)
+    t->store = world_store_open(o.world_file, height);
+
+  /*
+   * Only the right side can be generated ahead: going left (difficulty 0)
+   * needs the generator on the spot.
+   */
+  if (o.pregenerate > 0 && difficulty > 0)
+  {
+    t->queue = column_queue_new((size_t) o.pregenerate, height);
+    _start_producer(t);
+  }
+
+  return t;
+}
+
+/*
+ * Read what terrain_save() wrote, the file being positioned right after the
+ * game part. The grid is mapped from the file (MAP_PRIVATE, so the game never
+ * writes to it) when its offset is a multiple of the page size, read
+ * otherwise.
+ */
+terrain* terrain_load(void* const memory, const spaceship_options o, FILE* const file)
+{
+  terrain_record r;
+  _read(file, &r, sizeof r);
+
+  const size_t words = COLUMN_PLANES * column_words(o.height);
+  const size_t size = _grid_size(words, o.width);
+  const long page = sysconf(_SC_PAGESIZE);
+  if (r.grid_size != size || r.head >= (uint64_t) o.width)
+  {
+    fprintf(stderr, "load: the terrain doesn't match the options.\n");
+    exit(EX_DATAERR);
+  }
+
+  terrain* const t = _new(memory, o);
+  if (page > 0 && r.grid_offset % (uint64_t) page == 0)
+  {
+    /* The slot of the grid in memory is left unused. */
+    void* const p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+        fileno(file), (off_t) r.grid_offset);
+    if (p != MAP_FAILED)
+    {
+      t->grid = p;
+      t->mapped = size;
+      _place(t);
+    }
+  }
+  if (!t->mapped
+      && pread(fileno(file), t->grid, size, (off_t) r.grid_offset) != (ssize_t) size)
+  {
+    fprintf(stderr, "load: truncated terrain.\n");
+    exit(EX_DATAERR);
+  }
+
+  t->head = (size_t) r.head;
+  t->origin = r.origin;
+  t->genLow = (int) r.gen_low;
+  t->genHigh = (int) r.gen_high;
+  t->fall_count = (size_t) r.fall_count;
+  t->hash = r.hash;
+  _read(file, &t->random, sizeof t->random);
+  _read(file, t->dirty, sizeof *t->dirty * column_words(t->width));
+  _read(file, t->hashes, sizeof *t->hashes * (size_t) t->width);
+
+  /* The explored world goes on from the file the saved game left. */
+  if (t->difficulty <= 0)
+    t->store = world_store_reopen(o.world_file, t->height);
+
+  if (o.pregenerate > 0 && t->difficulty > 0)
+  {
+    t->queue = column_queue_new((size_t) o.pregenerate, t->height);
+    _start_producer(t);
   }
 
   return t;
 }
 
+/*
+ * Make t, a memcpy() of the footprint of from, a terrain of its own: a copy
+ * of the map alone, with no world store and no producer. Its random is the
+ * one right after the map, so it generates the columns the queue of from
+ * holds and the ones after them.
+ */
+void terrain_rebase(terrain* const t, const terrain* const from)
+{
+  t->grid = (uint64_t*) ((char*) t + _grid_offset(t->width));
+  if (from->mapped)
+    memcpy(t->grid, from->grid, _grid_size(t->words, t->width));
+  t->mapped = 0;
+  _place(t);
+  t->store = NULL;
+  t->queue = NULL;
+  t->generator = &t->random;
+}
+
 void terrain_destroy(terrain* const t)
 {
   if (!t)
     return;
 
-  if (t->columns)
-    column_list_destroy(t->columns);
-  free(t);
+  if (t->queue)
+  {
+    _stop_producer(t);
+    column_queue_destroy(t->queue);
+  }
+  world_store_close(t->store);
+  if (t->mapped)
+    munmap(t->grid, t->mapped);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -95,19 +303,19 @@ void terrain_destroy(terrain* const t)
 
 cell terrain_get_cell(const terrain* const t, const size_t x, const size_t y)
 {
-  const column* c = column_list_get_column(t->columns, x);
+  const column* c = terrain_get_column(t, x);
   const cell target = column_get_cell(c, y);
   return target;
 }
 
-column* terrain_get_column(const terrain* const t, const size_t x)
+bool terrain_is_wall(const terrain* const t, const size_t x, const size_t y)
 {
-  return column_list_get_column(t->columns, x);
+  return column_is_wall(terrain_get_column(t, x), y);
 }
 
-column_list* terrain_get_columns(const terrain* const t)
+column* terrain_get_column(const terrain* const t, const size_t x)
 {
-  return t->columns;
+  return x < (size_t) t->width ? t->views + _slot(t, x) : NULL;
 }
 
 point terrain_start_point(const terrain* const t)
@@ -126,6 +334,50 @@ point terrain_start_point(const terrain* const t)
   return (point) { .x = x, .y = y, };
 }
 
+size_t terrain_fall_count(const terrain* const t)
+{
+  return t->fall_count;
+}
+
+/* After terrain_fall(), whether a wall of column x moved. */
+bool terrain_is_dirty(const terrain* const t, const size_t x)
+{
+  if (x >= (size_t) t->width)
+    return false;
+  const size_t slot = _slot(t, x);
+  return t->dirty[slot / COLUMN_WORD_BITS] >> (slot % COLUMN_WORD_BITS) & 1;
+}
+
+/*
+ * After terrain_fall(), the first column from x on where a wall moved (before
+ * it, one that may move), or the width when there is none. Clean words of the
+ * dirty set are skipped at once.
+ */
+size_t terrain_next_dirty(const terrain* const t, size_t x)
+{
+  const size_t width = (size_t) t->width;
+  while (x < width)
+  {
+    const size_t slot = _slot(t, x);
+    const uint64_t bits = t->dirty[slot / COLUMN_WORD_BITS] >> (slot % COLUMN_WORD_BITS);
+    if (bits)
+    {
+      const size_t next = x + (size_t) __builtin_ctzll(bits);
+      return next < width ? next : width;
+    }
+    /* The rest of the word, up to the end of the slots where x wraps. */
+    const size_t end = (slot / COLUMN_WORD_BITS + 1) * COLUMN_WORD_BITS;
+    x += (end < width ? end : width) - slot;
+  }
+  return width;
+}
+
+/* Hash of every cell of the map, kept up to date as the map changes. */
+uint64_t terrain_hash(const terrain* const t)
+{
+  return t->hash;
+}
+
 int terrain_height(const terrain* const t)
 {
   return t->height;
@@ -140,33 +392,354 @@ int terrain_width(const terrain* const t)
 // setters / modifiers
 ////////////////////////////////////////////////////////////////////////////////
 
+void terrain_set_cell(
+    terrain* const t, const size_t x, const size_t y, const cell c)
+{
+  if (x >= (size_t) t->width)
+    return;
+  const size_t slot = _slot(t, x);
+  column* const view = t->views + slot;
+  const uint64_t key = _key(t, slot);
+  const size_t w = y / COLUMN_WORD_BITS;
+  const uint64_t before = column_hash_word(view, key, w);
+  column_set_cell(view, y, c);
+  const uint64_t change = before ^ column_hash_word(view, key, w);
+  t->hashes[slot] ^= change;
+  t->hash ^= change;
+  _mark_dirty(t, slot);
+}
+
+/*
+ * Write the terrain at the current position of file, see terrain_load().
+ * The producer can go on meanwhile: it doesn't touch random.
+ */
+void terrain_save(terrain* const t, FILE* const file)
+{
+  const size_t dirty_size = sizeof *t->dirty * column_words(t->width);
+  const size_t hashes_size = sizeof *t->hashes * (size_t) t->width;
+  const size_t end = (size_t) ftell(file) + sizeof (terrain_record)
+      + sizeof t->random + dirty_size + hashes_size;
+  const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  const terrain_record r =
+  {
+    .head = t->head,
+    .origin = t->origin,
+    .gen_low = t->genLow,
+    .gen_high = t->genHigh,
+    .fall_count = t->fall_count,
+    .hash = t->hash,
+    .grid_offset = (end + page - 1) / page * page,
+    .grid_size = _grid_size(t->words, t->width),
+  };
+  _write(file, &r, sizeof r);
+  _write(file, &t->random, sizeof t->random);
+  _write(file, t->dirty, dirty_size);
+  _write(file, t->hashes, hashes_size);
+
+  if (fseek(file, (long) r.grid_offset, SEEK_SET))
+  {
+    perror("fseek");
+    exit(EX_IOERR);
+  }
+  _write(file, t->grid, r.grid_size);
+}
+
 void terrain_right(terrain* const t)
 {
-  column* const c = terrain_new_column(t, false);
-  t->columns = column_list_push_back(t->columns, c);
-  t->columns = column_list_pop_front(t->columns);
+  /*
+   * The leftmost column is dropped and its slot is recycled for the new
+   * rightmost one.
+   */
+  column* const c = t->views + t->head;
+  if (t->store)
+  {
+    world_store_save(t->store, t->origin, c);
+    if (world_store_load(t->store, t->origin + t->width, c))
+      _step_generator(t, false);
+    else
+      terrain_new_column(t, c, false);
+  }
+  else if (t->queue)
+  {
+    const column* next = NULL;
+    while (!(next = column_queue_front(t->queue)))
+      /* The producer is late, let it run. */
+      sched_yield();
+    _load_column(t, t->head, next);
+    t->random = *column_queue_generator(t->queue, next);
+    column_queue_pop(t->queue);
+  }
+  else
+    terrain_new_column(t, c, false);
+  const size_t slot = t->head;
+  _mark_dirty(t, slot);
+  t->head = _slot(t, 1);
+  ++t->origin;
+  _rehash(t, slot);
 }
 
-void terrain_fall(terrain* const t)
+/* Returns whether a wall moved: only those columns stay dirty. */
+bool terrain_fall(terrain* const t)
 {
-  for (size_t c = 0; c < column_list_get_size(t->columns); ++c)
+  /*
+   * Gravity doesn't care about the order, walk the dirty slots directly.
+   * Row-major grids of single-word columns go through the vectorized kernel.
+   */
+  if (t->layout == LAYOUT_ROW_MAJOR && t->words == COLUMN_PLANES)
   {
-    column* const current = column_list_get_column(t->columns, c);
-    column_fall(current);
+#ifdef TERRAIN_CHECK_FALL
+    uint64_t* const before = malloc(_grid_size(t->words, t->width));
+    if (!before)
+    {
+      perror("malloc");
+      exit(EX_OSERR);
+    }
+    memcpy(before, t->grid, _grid_size(t->words, t->width));
+#endif
+    t->fall_count = column_fall_many(
+        t->grid, (size_t) t->width, (size_t) t->width, t->height, t->dirty);
+#ifdef TERRAIN_CHECK_FALL
+    _check_fall(t, before);
+    free(before);
+#endif
+  }
+  else
+  {
+    t->fall_count = 0;
+    for (size_t w = 0; w < column_words(t->width); ++w)
+    {
+      for (uint64_t bits = t->dirty[w]; bits; bits &= bits - 1)
+      {
+        const unsigned b = (unsigned) __builtin_ctzll(bits);
+        ++t->fall_count;
+        if (!column_fall(t->views + w * COLUMN_WORD_BITS + b))
+          t->dirty[w] &= ~(UINT64_C(1) << b);
+      }
+    }
+  }
+
+  /* Only the columns that moved have a new hash. */
+  bool moved = false;
+  for (size_t w = 0; w < column_words(t->width); ++w)
+  {
+    for (uint64_t bits = t->dirty[w]; bits; bits &= bits - 1)
+      _rehash(t, w * COLUMN_WORD_BITS + (size_t) __builtin_ctzll(bits));
+    moved |= t->dirty[w] != 0;
   }
+  return moved;
 }
 
 void terrain_left(terrain* const t)
 {
-  column* const c = terrain_new_column(t, true);
-  t->columns = column_list_push_front(t->columns, c);
-  t->columns = column_list_pop_back(t->columns);
+  /*
+   * The rightmost column is dropped and its slot is recycled for the new
+   * leftmost one.
+   */
+  t->head = _slot(t, (size_t) t->width - 1);
+  column* const c = t->views + t->head;
+  if (t->store)
+  {
+    world_store_save(t->store, t->origin + t->width - 1, c);
+    if (world_store_load(t->store, t->origin - 1, c))
+      _step_generator(t, true);
+    else
+      terrain_new_column(t, c, true);
+  }
+  else
+    terrain_new_column(t, c, true);
+  _mark_dirty(t, t->head);
+  --t->origin;
+  _rehash(t, t->head);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // local function definitions
 ////////////////////////////////////////////////////////////////////////////////
 
+size_t _slot(const terrain* const t, const size_t x)
+{
+  const size_t i = t->head + x;
+  return i >= (size_t) t->width ? i - (size_t) t->width : i;
+}
+
+void _mark_dirty(terrain* const t, const size_t slot)
+{
+  t->dirty[slot / COLUMN_WORD_BITS] |= UINT64_C(1) << (slot % COLUMN_WORD_BITS);
+}
+
+uint64_t _key(const terrain* const t, const size_t slot)
+{
+  const size_t x = slot >= t->head ? slot - t->head : slot + (size_t) t->width - t->head;
+  return prng_mix((uint64_t) (t->origin + (long) x));
+}
+
+void _rehash(terrain* const t, const size_t slot)
+{
+  const uint64_t hash = column_hash(t->views + slot, _key(t, slot));
+  t->hash ^= t->hashes[slot] ^ hash;
+  t->hashes[slot] = hash;
+}
+
+/* Copy a column generated by the producer into a slot of the grid. */
+void _load_column(terrain* const t, const size_t slot, const column* const c)
+{
+  column* const view = t->views + slot;
+  if (view->stride == 1)
+    memcpy(view->words, c->words, sizeof *c->words * t->words);
+  else
+    for (size_t i = 0; i < t->words; ++i)
+      view->words[i * view->stride] = c->words[i];
+}
+
+/*
+ * Keep the trigonometric generator in step with the world when a column
+ * comes from the store, so the next generated one joins its neighbours.
+ */
+void _step_generator(terrain* const t, const bool forward)
+{
+  t->genLow += forward ? 1 : -1;
+  t->genHigh += forward ? 1 : -1;
+}
+
+/* The parts of terrain_init() and terrain_load() that don't touch the cells. */
+terrain* _new(void* const memory, const spaceship_options o)
+{
+  terrain* const t = memory;
+  const int height = o.height;
+  const int width = o.width;
+  t->height = height;
+  t->width = width;
+  t->difficulty = o.difficulty;
+  t->layout = o.layout;
+  t->genLow = 0;
+  t->genHigh = 0;
+  t->head = 0;
+
+  t->words = COLUMN_PLANES * column_words(height);
+  t->grid = (uint64_t*) ((char*) t + _grid_offset(width));
+  t->mapped = 0;
+  _place(t);
+  memset(t->dirty, 0, sizeof *t->dirty * column_words(width));
+  t->fall_count = 0;
+  memset(t->hashes, 0, sizeof *t->hashes * (size_t) width);
+  t->hash = 0;
+  t->origin = 0;
+
+  t->generator = &t->random;
+  t->store = NULL;
+  t->queue = NULL;
+  atomic_init(&t->stop, false);
+  return t;
+}
+
+/* Point views, dirty and hashes right after the structure, views into grid. */
+void _place(terrain* const t)
+{
+  t->views = (column*) (t + 1);
+  t->dirty = (uint64_t*) (t->views + t->width);
+  t->hashes = t->dirty + column_words(t->width);
+  for (size_t k = 0; k < (size_t) t->width; ++k)
+  {
+    const bool rows = t->layout == LAYOUT_ROW_MAJOR;
+    t->views[k] = (column)
+    {
+      .words = t->grid + (rows ? k : k * t->words),
+      .height = t->height,
+      .stride = rows ? (size_t) t->width : 1,
+    };
+  }
+}
+
+void _start_producer(terrain* const t)
+{
+  t->generator = malloc(sizeof *t->generator);
+  if (!t->generator)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  *t->generator = t->random;
+  atomic_store(&t->stop, false);
+  const int error = pthread_create(&t->producer, NULL, _produce, t);
+  if (error)
+  {
+    fprintf(stderr, "pthread_create: %s\n", strerror(error));
+    exit(EX_OSERR);
+  }
+}
+
+void _stop_producer(terrain* const t)
+{
+  atomic_store(&t->stop, true);
+  pthread_join(t->producer, NULL);
+  free(t->generator);
+  t->generator = &t->random;
+}
+
+/* Producer thread: keep the queue full until terrain_destroy(). */
+void* _produce(void* const arg)
+{
+  terrain* const t = arg;
+  const struct timespec nap = { .tv_sec = 0, .tv_nsec = 1000000, };
+  while (!atomic_load_explicit(&t->stop, memory_order_relaxed))
+  {
+    column* const c = column_queue_back(t->queue);
+    if (!c)
+    {
+      /* Full: the consumer only takes one column per tick. */
+      nanosleep(&nap, NULL);
+      continue;
+    }
+    terrain_new_column(t, c, false);
+    *column_queue_generator(t->queue, c) = *t->generator;
+    column_queue_push(t->queue);
+  }
+  return NULL;
+}
+
+/* aligned_alloc() wants a multiple of the alignment. */
+size_t _grid_size(const size_t words, const int width)
+{
+  const size_t size = sizeof (uint64_t) * words * (size_t) width;
+  return size + (TERRAIN_ALIGNMENT - size % TERRAIN_ALIGNMENT) % TERRAIN_ALIGNMENT;
+}
+
+/* Where the grid starts in the footprint: after the rest, aligned. */
+size_t _grid_offset(const int width)
+{
+  const size_t size = sizeof (terrain) + sizeof (column) * (size_t) width
+      + sizeof (uint64_t) * (column_words(width) + (size_t) width);
+  return size + (TERRAIN_ALIGNMENT - size % TERRAIN_ALIGNMENT) % TERRAIN_ALIGNMENT;
+}
+
+#ifdef TERRAIN_CHECK_FALL
+/* Replay the fall with column_fall() on the old grid and compare. */
+void _check_fall(const terrain* const t, const uint64_t* const before)
+{
+  uint64_t* const expected = malloc(_grid_size(t->words, t->width));
+  if (!expected)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  memcpy(expected, before, _grid_size(t->words, t->width));
+  for (size_t k = 0; k < (size_t) t->width; ++k)
+  {
+    column view = t->views[k];
+    view.words = expected + (view.words - t->grid);
+    column_fall(&view);
+  }
+  for (size_t i = 0; i < t->words * (size_t) t->width; ++i)
+    if (expected[i] != t->grid[i])
+    {
+      fprintf(stderr, "terrain_fall: word %zu is %#"PRIx64", expected %#"PRIx64"\n",
+          i, t->grid[i], expected[i]);
+      abort();
+    }
+  free(expected);
+}
+#endif
+
 int _trig_low(const int genLow, const double hmin)
 {
   const double gen = sin(genLow / 3.14) * 6.0;
@@ -179,71 +752,69 @@ int _trig_high(const int genHigh, const double height)
   return (int) (gen > height ? height : gen);
 }
 
-column* _trig_column(const int genLow, const int genHigh, const int height)
+void _trig_column(column* const c, const int genLow, const int genHigh)
 {
-  int high = _trig_high(genHigh, height);
+  int high = _trig_high(genHigh, c->height);
   int low = _trig_low(genLow, 0);
-  column* c = column_new(height, low, high);
-
-  return c;
+  column_reset(c, low, high);
 }
 
-int _random_generation_selection(const int difficulty)
+int _random_generation_selection(terrain* const t)
 {
-  return difficulty + (random() % 100 < 2 ? 1 : 0);
+  return t->difficulty + (prng_random(t->generator) % 100 < 2 ? 1 : 0);
 }
 
-column* _random_column(const int height, const int difficulty)
+void _random_column(terrain* const t, column* const c)
 {
+  prng* const r = t->generator;
+  const int height = c->height;
   const int half = height / 2;
-  const int selection = _random_generation_selection(difficulty);
+  const int selection = _random_generation_selection(t);
 
   int top = 0;
   int bottom = 0;
 
   if (selection <= 1)
   {
-    const int bias_divisor = 2 + (int) random() % 4;
+    const int bias_divisor = 2 + (int) prng_random(r) % 4;
     const int bias_limit = height / bias_divisor;
-    const int bias = (int) (random() % (bias_limit));
-    top = (int) (random() % half) + bias;
-    bottom = half + (int) (random() % half) - bias;
+    const int bias = (int) (prng_random(r) % (bias_limit));
+    top = (int) (prng_random(r) % half) + bias;
+    bottom = half + (int) (prng_random(r) % half) - bias;
     top = top > bottom ? bottom - 1 : top;
     top = top < 0 ? 0 : top;
   }
   else
   {
-    top = (int) (random() % height);
+    top = (int) (prng_random(r) % height);
     if (top > half)
-      top -= (int) (random() % half);
+      top -= (int) (prng_random(r) % half);
 
-    bottom = (int) (random() % (height - top) + top);
+    bottom = (int) (prng_random(r) % (height - top) + top);
     if ((bottom - top) <= 1)
-      bottom += (int) (random() % half);
+      bottom += (int) (prng_random(r) % half);
   }
 
-  return column_new(height, top, bottom);
+  column_reset(c, top, bottom);
 }
 
-column* terrain_new_column(terrain* const t, const bool forward)
+void terrain_new_column(terrain* const t, column* const c, const bool forward)
 {
   const int difficulty = t->difficulty;
-  column* c = NULL;
   if (difficulty <= 0)
   {
-    t->genLow += forward ? 1 : -1;
-    t->genHigh += forward ? 1 : -1;
-    c = _trig_column(t->genLow, t->genHigh, t->height);
+    _step_generator(t, forward);
+    _trig_column(c, t->genLow, t->genHigh);
   }
   else if (difficulty >= 1)
   {
-    c = _random_column(t->height, difficulty);
+    _random_column(t, c);
     const int threshold = 10 - difficulty;
-    const int threshold_number = (int) random() % 100;
+    const int threshold_number = (int) prng_random(t->generator) % 100;
     if (threshold_number < threshold)
     {
-      const int selector = (int) random() % 100;
-      const size_t y = (size_t) (random() % t->height);
+      const int selector = (int) prng_random(t->generator) % 100;
+      const size_t y = (size_t) (prng_random(t->generator) % t->height);
 
       cell selection = CELL_EMPTY;
       if (selector < 30)
@@ -257,6 +828,22 @@ column* terrain_new_column(terrain* const t, const bool forward)
       column_set_cell(c, y, selection);
     }
   }
+}
+
+void _read(FILE* const file, void* const data, const size_t size)
+{
+  if (fread(data, 1, size, file) != size)
+  {
+    fprintf(stderr, "load: truncated terrain.\n");
+    exit(EX_DATAERR);
+  }
+}
 
-  return c;
+void _write(FILE* const file, const void* const data, const size_t size)
+{
+  if (fwrite(data, 1, size, file) != size)
+  {
+    perror("save");
+    exit(EX_IOERR);
+  }
 }
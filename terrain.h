@@ -19,7 +19,17 @@
 
 #include "point.h"
 #include "column.h"
-#include "column_list.h"
+#include "options.h"
+#include "prng.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* Alignment of the grid, and of the memory given to terrain_init(). */
+#ifndef TERRAIN_ALIGNMENT
+  #define TERRAIN_ALIGNMENT 64
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // types
@@ -31,7 +41,10 @@ typedef struct terrain terrain;
 // init./destroy etc.
 ////////////////////////////////////////////////////////////////////////////////
 
-terrain* terrain_init(int height, int width, int difficulty);
+size_t terrain_footprint(spaceship_options o);
+terrain* terrain_init(void* memory, spaceship_options o);
+terrain* terrain_load(void* memory, spaceship_options o, FILE* file);
+void terrain_rebase(terrain* t, const terrain* from);
 void terrain_destroy(terrain* t);
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -39,9 +52,13 @@ void terrain_destroy(terrain* t);
 ////////////////////////////////////////////////////////////////////////////////
 
 cell terrain_get_cell(const terrain* l, size_t x, size_t y);
+bool terrain_is_wall(const terrain* l, size_t x, size_t y);
 column* terrain_get_column(const terrain* l, size_t x);
-column_list* terrain_get_columns(const terrain* l);
 point terrain_start_point(const terrain* l);
+size_t terrain_fall_count(const terrain* l);
+bool terrain_is_dirty(const terrain* t, size_t x);
+size_t terrain_next_dirty(const terrain* t, size_t x);
+uint64_t terrain_hash(const terrain* t);
 int terrain_height(const terrain* columns);
 int terrain_width(const terrain* columns);
 
@@ -49,8 +66,10 @@ int terrain_width(const terrain* columns);
 // setters / modifiers
 ////////////////////////////////////////////////////////////////////////////////
 
+void terrain_save(terrain* t, FILE* file);
+void terrain_set_cell(terrain* l, size_t x, size_t y, cell c);
 void terrain_left(terrain* l);
 void terrain_right(terrain* l);
-void terrain_fall(terrain* columns);
+bool terrain_fall(terrain* columns);
 
 #endif
@@ -18,17 +18,53 @@
 #include <stdio.h>
 #include <ncurses.h>
 #include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
 #include <sysexits.h>
 
+#include "autopilot.h"
+#include "speed_curve.h"
+#include "node_pool.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+/* Turns run in a row when the loop is late, before it gives up on them. */
+#ifndef UI_MAX_CATCH_UP
+  #define UI_MAX_CATCH_UP 5
+#endif
+/* Columns left for the infos and debug windows with --large-world. */
+#ifndef UI_INFOS_WIDTH
+  #define UI_INFOS_WIDTH 32
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // types
 ////////////////////////////////////////////////////////////////////////////////
 
+/*
+ * The part of the map shown in game_window, in map coordinates. In debug
+ * mode, digits is the width of the row numbers on each side of it.
+ */
+typedef struct viewport
+{
+  int x;
+  int y;
+  int width;
+  int height;
+  int digits;
+} viewport;
+
 struct interface
 {
+  viewport view;
   WINDOW* game_window;
   WINDOW* debug_window;
   WINDOW* infos_window;
+  autopilot* pilot;
+  speed_curve* curve;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,10 +88,11 @@ static const char* cell_strings[] =
 
 static inline chtype _cell_chtype(cell c);
 static inline void _cell_wprint(WINDOW* window, cell c, bool pretty);
-static inline double _threshold(spaceship_options options, double d);
 static inline double _time_difference(struct timespec t0, struct timespec t1);
-static void _display_game(WINDOW* window, const game* g);
-static void _display_debug(WINDOW* window, const game* g);
+static inline int _follow(int position, int origin, int size, int total);
+static inline int _digits(int n);
+static void _display_game(WINDOW* window, viewport* view, const game* g);
+static void _display_debug(WINDOW* window, const game* g, const autopilot* pilot);
 static void _display_infos(WINDOW* window, const game* g);
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -97,13 +134,31 @@ interface* interface_init(const spaceship_options o)
   int x, y;
   getmaxyx(stdscr, y, x);
 
+  /*
+   * A large world is seen through a viewport that fits in the terminal, the
+   * rest of the time the whole map is displayed.
+   */
+  const int digits = _digits(o.height - 1);
+  const int labels = o.debug ? 2 * (digits + 1) : 0;
+  ui->view = (viewport) {
+    .x = 0, .y = 0, .width = o.width, .height = o.height, .digits = digits,
+  };
+  if (o.large_world)
+  {
+    const int max_width = x - 2 - labels - UI_INFOS_WIDTH;
+    const int max_height = y - 2 - (o.debug ? 2 : 0);
+    ui->view.width = max_width < 1 ? 1 : max_width < o.width ? max_width : o.width;
+    ui->view.height =
+        max_height < 1 ? 1 : max_height < o.height ? max_height : o.height;
+  }
+
   /* 
    * Game window dimensions:
    * - add 2 to the height and width because we display a border around the map
-   * - add 2 or 6 in debug mode because we display coordinates
+   * - add 2 and labels in debug mode because we display coordinates
    */
-  const int game_height = o.height + 2 + (o.debug ? 2 : 0);
-  const int game_width = o.width + 2 + (o.debug ? 6 : 0);
+  const int game_height = ui->view.height + 2 + (o.debug ? 2 : 0);
+  const int game_width = ui->view.width + 2 + labels;
   const int game_y = y > game_height ? (y - game_height) / 2 : 0;
   const int game_x = x > game_width ? (x - game_width) / 2 : 0;
   WINDOW* const game_window = newwin(game_height, game_width, game_y, game_x);
@@ -143,6 +198,8 @@ interface* interface_init(const spaceship_options o)
   ui->game_window = game_window;
   ui->debug_window = debug_window;
   ui->infos_window = infos_window;
+  ui->pilot = NULL;
+  ui->curve = NULL;
 
   return ui;
 }
@@ -168,6 +225,8 @@ void interface_destroy(interface* const ui)
     delwin(ui->infos_window);
   endwin();
 
+  autopilot_destroy(ui->pilot);
+  speed_curve_destroy(ui->curve);
   free(ui);
 }
 
@@ -177,53 +236,81 @@ void interface_destroy(interface* const ui)
 
 void interface_display(interface* const ui, const game* const g)
 {
-  _display_game(ui->game_window, g);
+  _display_game(ui->game_window, &ui->view, g);
   _display_infos(ui->infos_window, g);
-  _display_debug(ui->debug_window, g);
+  _display_debug(ui->debug_window, g, ui->pilot);
 }
 
 void interface_game_loop(interface* const ui, game* const g)
 {
   /*
-   * Disclaimer: don't do it this way in the real world!
-   * Frames should be refreshed at a constant rate...
-   *
-   * Use timers, signals or even a dedicated game library!
+   * Turns are due at fixed times: wait in poll() until a key arrives or the
+   * next one is due, instead of spinning on wgetch(). After a late wake-up,
+   * the missed turns run back to back before the screen is redrawn; past
+   * UI_MAX_CATCH_UP of them, the schedule restarts from now.
    */
   const spaceship_options options = game_get_options(g);
-  struct timespec start, current, last;
+  struct timespec start, current;
   clock_gettime(CLOCK_MONOTONIC, &start);
-  last = start;
+  struct pollfd input = { .fd = STDIN_FILENO, .events = POLLIN, };
+  if (options.autopilot && !ui->pilot)
+    ui->pilot = autopilot_new(g, options.threads > 0
+        ? (size_t) options.threads : (size_t) sysconf(_SC_NPROCESSORS_ONLN));
+  if (!ui->curve)
+    ui->curve = speed_curve_new(&options);
+  const speed_curve* const curve = ui->curve;
+  /* A loaded game goes on from its own elapsed time. */
+  const double resumed = game_get_elapsed_time(g);
+  double next = resumed + speed_curve_delay(curve, resumed);
 
-  const double constant_delay = game_get_constant_delay(g);
   while (1)
   {
     clock_gettime(CLOCK_MONOTONIC, &current);
+    double elapsed = resumed + _time_difference(start, current);
 
-    const int c = wgetch(ui->game_window);
-    if (c == 'q')
-      break;
-
-    const double elapsed = _time_difference(start, current);
-    const double delay = constant_delay > 0.0 ? constant_delay : _threshold(options, elapsed);
-    const double d = _time_difference(last, current);
+    /* In a still world, only 's' makes time go by. */
+    int timeout = -1;
+    if (!options.still)
+      timeout = next > elapsed ? (int) ((next - elapsed) * 1000.0) + 1 : 0;
+    if (timeout && poll(&input, 1, timeout) < 0 && errno != EINTR)
+    {
+      perror("poll");
+      exit(EX_OSERR);
+    }
 
-    game_set_delay(g, delay);
+    clock_gettime(CLOCK_MONOTONIC, &current);
+    elapsed = resumed + _time_difference(start, current);
+    game_set_delay(g, speed_curve_delay(curve, elapsed));
     game_set_elapsed_time(g, elapsed);
-    if (c != ERR)
+
+    bool changed = false;
+    for (int c; game_ship_is_alive(g) && (c = wgetch(ui->game_window)) != ERR; )
     {
+      if (c == 'q')
+        return;
       game_process_input(g, c);
-      interface_display(ui, g);
-      wrefresh(ui->game_window);
+      if (options.still && c == 's')
+        game_compute_turn(g);
+      changed = true;
     }
 
-    if ((options.still && c == 's') || (!options.still && d > delay))
+    for (int turns = 0; !options.still && game_ship_is_alive(g) && elapsed >= next; ++turns)
     {
+      if (turns == UI_MAX_CATCH_UP)
+      {
+        next = elapsed + speed_curve_delay(curve, elapsed);
+        break;
+      }
+      if (ui->pilot)
+        game_process_input(g, autopilot_next_key(ui->pilot, g));
       game_compute_turn(g);
-      interface_display(ui, g);
-      last = current;
+      next += speed_curve_delay(curve, next);
+      changed = true;
     }
 
+    if (changed)
+      interface_display(ui, g);
+
     if (!game_ship_is_alive(g))
     {
       interface_game_over(ui, options);
@@ -234,8 +321,8 @@ void interface_game_loop(interface* const ui, game* const g)
 
 void interface_game_over(interface* const ui, const spaceship_options o)
 {
-  const int x = (o.width + 2 - 11) / 2 + 1 + (o.debug ? 3 : 0);
-  const int y = (o.height + 2) / 2 + (o.debug ? 1 : 0);
+  const int x = (ui->view.width + 2 - 11) / 2 + 1 + (o.debug ? ui->view.digits + 1 : 0);
+  const int y = (ui->view.height + 2) / 2 + (o.debug ? 1 : 0);
 
   wattron(ui->game_window, A_REVERSE | A_BOLD | A_BLINK | COLOR_PAIR(1));
   wmove(ui->game_window, y, x);
@@ -299,24 +386,6 @@ void _cell_wprint(WINDOW* const window, const cell c, const bool pretty)
     wattroff(window, COLOR_PAIR(5));
 }
 
-double _threshold(const spaceship_options options, const double d)
-{
-  const int difficulty = options.difficulty;
-
-  switch (difficulty)
-  {
-    case 0:
-      return d > 59.0 ? 0.3 : (1.0 - d / 60.0);
-      break;
-    case 1:
-      return d > 30.0 ? 0.25 : (1.0 - d / 45.0);
-      break;
-    default:
-      return d > 14.0 ? 0.15 : (1.0 - d / 15.0);
-      break;
-  }
-}
-
 double _time_difference(const struct timespec t0, const struct timespec t1)
 {
   double difference = difftime(t1.tv_sec, t0.tv_sec);
@@ -334,17 +403,43 @@ double _time_difference(const struct timespec t0, const struct timespec t1)
   return difference;
 }
 
-void _display_game(WINDOW* const window, const game* const g)
+/* Scroll one axis of the viewport to keep position away from its edges. */
+int _follow(const int position, int origin, const int size, const int total)
+{
+  const int margin = size / 4;
+  if (position < origin + margin)
+    origin = position - margin;
+  if (position >= origin + size - margin)
+    origin = position - size + margin + 1;
+  origin = origin > total - size ? total - size : origin;
+  return origin < 0 ? 0 : origin;
+}
+
+/* Decimal digits of n >= 0, at least the two the row numbers always had. */
+int _digits(int n)
+{
+  int digits = 1;
+  for (; n >= 10; n /= 10)
+    ++digits;
+  return digits < 2 ? 2 : digits;
+}
+
+void _display_game(WINDOW* const window, viewport* const view, const game* const g)
 {
   const spaceship_options options = game_get_options(g);
   const bool debug = options.debug;
   const bool pretty = options.pretty;
   const terrain* const map = game_get_map(g);
-  const int height = terrain_height(map);
-  const int width = terrain_width(map);
+  const point ship = game_get_ship_position(g);
+  view->x = _follow(ship.x, view->x, view->width, terrain_width(map));
+  view->y = _follow(ship.y, view->y, view->height, terrain_height(map));
+  const int height = view->height;
+  const int width = view->width;
 
-  const int shift_x = debug ? 4 : 1;
-  const int shift_y = 1 + (debug ? 1 : 0);
+  /* Screen position of the map point (0, 0). */
+  const int left = debug ? view->digits + 2 : 1;
+  const int shift_x = left - view->x;
+  const int shift_y = 1 + (debug ? 1 : 0) - view->y;
 
   /* FIRST STEP: erase the window to get rid of remnant characters. */
   werase(window);
@@ -357,10 +452,10 @@ void _display_game(WINDOW* const window, const game* const g)
   wattroff(window, A_DIM | COLOR_PAIR(3));
 
   /* Map. */
-  for (int l = 0; l < height; ++l)
+  for (int l = view->y; l < view->y + height; ++l)
   {
-    wmove(window, l + shift_y, shift_x);
-    for(size_t c = 0; c < (size_t) width; ++c)
+    wmove(window, l + shift_y, view->x + shift_x);
+    for(size_t c = (size_t) view->x; c < (size_t) (view->x + width); ++c)
     {
       const cell current_cell = terrain_get_cell(map, c, (size_t) l);
       _cell_wprint(window, current_cell, pretty);
@@ -368,7 +463,6 @@ void _display_game(WINDOW* const window, const game* const g)
   }
 
   /* Ship. */
-  const point ship = game_get_ship_position(g);
   const cell ship_cell = terrain_get_cell(map, (size_t) ship.x, (size_t) ship.y);
   const bool ship_dead = ship_cell == CELL_WALL;
   wmove(window, ship.y + shift_y, ship.x + shift_x);
@@ -378,7 +472,7 @@ void _display_game(WINDOW* const window, const game* const g)
   if (pretty)
   {
     waddch(window, ACS_RTEE);
-    if (ship.x > 0)
+    if (ship.x > view->x)
     {
       const cell tail_cell =
           terrain_get_cell(map, (size_t) ship.x - 1, (size_t) ship.y);
@@ -396,14 +490,17 @@ void _display_game(WINDOW* const window, const game* const g)
     wattroff(window, A_BLINK);
 
   /* Bullets. */
-  const point_list* const bullets = game_get_bullets(g);
-  const size_t count = point_list_get_size(bullets);
+  const bullet_array* const bullets = game_get_bullets(g);
+  const size_t count = bullet_array_get_size(bullets);
   for (size_t i = 0; i < count; ++i)
   {
-    const point bullet = point_list_get_point(bullets, i);
-    if (point_is_valid(bullet))
+    const point bullet = bullet_array_get_point(bullets, i);
+    const bool visible =
+        bullet.x >= view->x && bullet.x < view->x + width
+        && bullet.y >= view->y && bullet.y < view->y + height;
+    if (point_is_valid(bullet) && visible)
     {
-      wmove(window, bullet.y + 1 + (debug ? 1 : 0), bullet.x + (debug ? 4 : 1));
+      wmove(window, bullet.y + shift_y, bullet.x + shift_x);
       wattron(window, A_BOLD | COLOR_PAIR(3));
       if (pretty)
         waddch(window, ACS_DIAMOND);
@@ -421,23 +518,25 @@ void _display_game(WINDOW* const window, const game* const g)
     /* Top/bottom coordinates. */
     for(size_t c = 0; c < (size_t) width; ++c)
     {
-      const bool is_ten = !(c % 10);
+      const size_t x = c + (size_t) view->x;
+      const bool is_ten = !(x % 10);
       if (is_ten)
         wattron(window, A_BOLD);
-      wmove(window, 1, 4 + (int) c);
-      wprintw(window, "%zu", c % 10);
-      wmove(window, 2 + height, 4 + (int) c);
-      wprintw(window, "%zu", c % 10);
+      wmove(window, 1, left + (int) c);
+      wprintw(window, "%zu", x % 10);
+      wmove(window, 2 + height, left + (int) c);
+      wprintw(window, "%zu", x % 10);
       if (is_ten)
         wattroff(window, A_BOLD);
     }
     /* Left/right coordinates. */
     for (int l = 0; l < height; ++l)
     {
+      const int y = l + view->y;
       wmove(window, l + 1 + (debug ? 1 : 0), 1);
-      wprintw(window, "%2d ", l);
-      wmove(window, l + 1 + (debug ? 1 : 0), width + 4);
-      wprintw(window, "%2d ", l);
+      wprintw(window, "%*d ", view->digits, y);
+      wmove(window, l + 1 + (debug ? 1 : 0), width + left);
+      wprintw(window, "%*d ", view->digits, y);
     }
 
     wattroff(window, A_DIM);
@@ -447,7 +546,8 @@ void _display_game(WINDOW* const window, const game* const g)
   wrefresh(window);
 }
 
-void _display_debug(WINDOW* const window, const game* const g)
+void _display_debug(
+    WINDOW* const window, const game* const g, const autopilot* const pilot)
 {
   const spaceship_options options = game_get_options(g);
   if (!options.debug)
@@ -458,9 +558,12 @@ void _display_debug(WINDOW* const window, const game* const g)
   const int last_input = game_get_last_input(g);
   const size_t max_ammo = game_get_max_ammo(g);
   const size_t fired = game_get_fired_bullets(g);
-  const point_list* bullets = game_get_bullets(g);
+  const bullet_array* bullets = game_get_bullets(g);
   const intmax_t bonus = options.bonus;
   const intmax_t malus = options.malus;
+  const size_t fallen = terrain_fall_count(game_get_map(g));
+  const uint64_t hash = game_get_hash(g);
+  const node_pool_stats nodes = node_pool_get_stats();
 
   /* FIRST STEP: erase the window to get rid of remnant characters. */
   werase(window);
@@ -478,16 +581,27 @@ void _display_debug(WINDOW* const window, const game* const g)
   wprintw(window, " - Delay: %lf\n", delay);
   wprintw(window, " - Position: (%d, %d)\n", ship.x, ship.y);
   wprintw(window, " - Difficulty: %d\n", options.difficulty);
+  wprintw(window, " - Seed: %"PRIu64"\n", options.seed);
+  wprintw(window, " - Gravity: %zu columns\n", fallen);
+  wprintw(window, " - Hash: %016"PRIx64"\n", hash);
+  wprintw(window, " - Allocations: %zu heap, %zu nodes (%zu live, %zu slabs)\n",
+      nodes.heap, nodes.allocations, nodes.live, nodes.slabs);
+  if (pilot)
+  {
+    const autopilot_stats stats = autopilot_get_stats(pilot);
+    wprintw(window, " - Autopilot: %.0f nodes/s\n",
+        stats.seconds > 0.0 ? (double) stats.nodes / stats.seconds : 0.0);
+  }
   if (last_input)
     wprintw(window, " - Last keystroke: '%c' (%d)\n", last_input, last_input);
   wprintw(window, " - Bonus: %"PRIdMAX"\n", bonus);
   wprintw(window, " - Malus: %"PRIdMAX"\n", malus);
   wprintw(window, " - Max ammo: %zu\n", max_ammo);
   wprintw(window, " - Fired: %zu\n", fired);
-  const size_t count = point_list_get_size(bullets);
+  const size_t count = bullet_array_get_size(bullets);
   for (size_t i = 0; i < count; ++i)
   {
-    const point bullet = point_list_get_point(bullets, i);
+    const point bullet = bullet_array_get_point(bullets, i);
     wprintw(window, "     (%d, %d)\n", bullet.x, bullet.y);
   }
   wattroff(window, A_DIM);
@@ -0,0 +1,263 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "work_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Each worker starts with a contiguous share of the indices, packed as
+ * begin << 32 | end in one atomic word. The owner takes from the front; an
+ * idle worker steals the back half of someone else's range. Both are a single
+ * compare-and-swap on that word, and ranges only ever shrink.
+ */
+typedef struct worker
+{
+  _Alignas(64) atomic_uint_fast64_t range;
+  struct work_pool* pool;
+  size_t id;
+  pthread_t thread;
+} worker;
+
+/*
+ * Worker 0 is the thread calling work_pool_run(), the others wait for the
+ * next run: run counts them, busy is how many workers are still on the
+ * current one.
+ */
+struct work_pool
+{
+  worker* workers;
+  size_t threads;
+  work_pool_job job;
+  void* arg;
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long run;
+  size_t busy;
+  bool stop;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t _pack(uint64_t begin, uint64_t end);
+static bool _take(worker* w, size_t* index);
+static bool _steal(worker* thief, worker* victim, size_t* index);
+static void _work(worker* w);
+static void* _wait(void* arg);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+work_pool* work_pool_new(size_t threads)
+{
+  threads = threads < 1 ? 1 : threads;
+  work_pool* const pool = malloc(sizeof *pool);
+  if (!pool)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+  pool->workers = aligned_alloc(_Alignof(worker), sizeof *pool->workers * threads);
+  if (!pool->workers)
+  {
+    perror("aligned_alloc");
+    exit(EX_OSERR);
+  }
+  pool->threads = threads;
+  pool->job = NULL;
+  pool->arg = NULL;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pool->run = 0;
+  pool->busy = 0;
+  pool->stop = false;
+
+  for (size_t i = 0; i < threads; ++i)
+  {
+    worker* const w = pool->workers + i;
+    atomic_init(&w->range, _pack(0, 0));
+    w->pool = pool;
+    w->id = i;
+  }
+  for (size_t i = 1; i < threads; ++i)
+  {
+    const int error = pthread_create(&pool->workers[i].thread, NULL, _wait, pool->workers + i);
+    if (error)
+    {
+      fprintf(stderr, "pthread_create: %s\n", strerror(error));
+      exit(EX_OSERR);
+    }
+  }
+  return pool;
+}
+
+void work_pool_destroy(work_pool* const pool)
+{
+  if (!pool)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 1; i < pool->threads; ++i)
+    pthread_join(pool->workers[i].thread, NULL);
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  free(pool->workers);
+  free(pool);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// misc.
+////////////////////////////////////////////////////////////////////////////////
+
+/* Call job for every index in [0, count) and return once they are all done. */
+void work_pool_run(
+    work_pool* const pool, const size_t count, const work_pool_job job, void* const arg)
+{
+  if (count > UINT32_MAX)
+  {
+    fprintf(stderr, "work_pool_run: too many jobs (%zu).\n", count);
+    exit(EX_USAGE);
+  }
+
+  const size_t threads = pool->threads;
+  pthread_mutex_lock(&pool->lock);
+  pool->job = job;
+  pool->arg = arg;
+  for (size_t i = 0; i < threads; ++i)
+    atomic_store(&pool->workers[i].range,
+        _pack(count * i / threads, count * (i + 1) / threads));
+  pool->busy = threads - 1;
+  ++pool->run;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  _work(pool->workers);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t _pack(const uint64_t begin, const uint64_t end)
+{
+  return begin << 32 | end;
+}
+
+bool _take(worker* const w, size_t* const index)
+{
+  uint_fast64_t range = atomic_load(&w->range);
+  for (;;)
+  {
+    const uint64_t begin = range >> 32;
+    const uint64_t end = range & UINT32_MAX;
+    if (begin >= end)
+      return false;
+    if (atomic_compare_exchange_weak(&w->range, &range, _pack(begin + 1, end)))
+    {
+      *index = (size_t) begin;
+      return true;
+    }
+  }
+}
+
+/* Move the back half of the victim's range to the thief, keep one index. */
+bool _steal(worker* const thief, worker* const victim, size_t* const index)
+{
+  uint_fast64_t range = atomic_load(&victim->range);
+  for (;;)
+  {
+    const uint64_t begin = range >> 32;
+    const uint64_t end = range & UINT32_MAX;
+    if (begin >= end)
+      return false;
+    const uint64_t middle = begin + (end - begin) / 2;
+    if (atomic_compare_exchange_weak(&victim->range, &range, _pack(begin, middle)))
+    {
+      /* Only thieves touch an empty range, and they leave it alone. */
+      atomic_store(&thief->range, _pack(middle + 1, end));
+      *index = (size_t) middle;
+      return true;
+    }
+  }
+}
+
+void _work(worker* const w)
+{
+  work_pool* const pool = w->pool;
+  for (;;)
+  {
+    size_t index = 0;
+    bool found = _take(w, &index);
+    for (size_t i = 1; !found && i < pool->threads; ++i)
+      found = _steal(w, pool->workers + (w->id + i) % pool->threads, &index);
+    if (!found)
+      return;
+    pool->job(index, pool->arg);
+  }
+}
+
+/* The loop of workers 1 and up: one _work() per run until the pool stops. */
+void* _wait(void* const arg)
+{
+  worker* const w = arg;
+  work_pool* const pool = w->pool;
+  unsigned long seen = 0;
+  for (;;)
+  {
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop && pool->run == seen)
+      pthread_cond_wait(&pool->start, &pool->lock);
+    if (pool->stop)
+    {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
+    }
+    seen = pool->run;
+    pthread_mutex_unlock(&pool->lock);
+
+    _work(w);
+
+    pthread_mutex_lock(&pool->lock);
+    if (!--pool->busy)
+      pthread_cond_signal(&pool->done);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef _WORK_POOL_H_
+#define _WORK_POOL_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/* Called once for every index in [0, count), from any worker thread. */
+typedef void (*work_pool_job)(size_t index, void* arg);
+
+/*
+ * Threads started once and kept waiting between runs, so that running a few
+ * jobs every turn doesn't start and join threads every turn.
+ */
+typedef struct work_pool work_pool;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+work_pool* work_pool_new(size_t threads);
+void work_pool_destroy(work_pool* pool);
+
+////////////////////////////////////////////////////////////////////////////////
+// misc.
+////////////////////////////////////////////////////////////////////////////////
+
+void work_pool_run(work_pool* pool, size_t count, work_pool_job job, void* arg);
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+#include "world_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sysexits.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// macros
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef WORLD_CHUNK_COLUMNS
+  #define WORLD_CHUNK_COLUMNS 64
+#endif
+#ifndef WORLD_MAPPED_CHUNKS
+  #define WORLD_MAPPED_CHUNKS 4
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A chunk starts with its id and a bitmask of the columns it actually holds,
+ * followed by the planes of its WORLD_CHUNK_COLUMNS columns, and is padded to
+ * a page. The ids let a reopened file find its chunks again.
+ */
+typedef struct world_chunk
+{
+  long id;
+  uint64_t* data;
+} world_chunk;
+
+/*
+ * The player scrolls one column at a time, so the chunks ever visited form
+ * a range: offsets[i] is the file chunk holding chunk first + i, or -1.
+ */
+struct world_store
+{
+  FILE* file;
+  int fd;
+  size_t words;
+  size_t chunk_size;
+  long chunks;
+  long first;
+  long* offsets;
+  size_t count;
+  world_chunk mapped[WORLD_MAPPED_CHUNKS];
+  size_t victim;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions declarations
+////////////////////////////////////////////////////////////////////////////////
+
+static world_store* _new(FILE* file, int height);
+static inline long _chunk_id(long x);
+static long* _offset(world_store* s, long id);
+static uint64_t* _map(world_store* s, long id, bool create);
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+/* Without a path, the history goes to an anonymous temporary file. */
+world_store* world_store_open(const char* const path, const int height)
+{
+  FILE* const file = path ? fopen(path, "w+b") : tmpfile();
+  if (!file)
+  {
+    perror(path ? path : "tmpfile");
+    exit(EX_CANTCREAT);
+  }
+  return _new(file, height);
+}
+
+/*
+ * Open the store a saved game left in path, keeping its columns. A missing
+ * file starts an empty store, as world_store_open() does.
+ */
+world_store* world_store_reopen(const char* const path, const int height)
+{
+  FILE* const file = path ? fopen(path, "r+b") : NULL;
+  if (!file)
+    return world_store_open(path, height);
+
+  world_store* const s = _new(file, height);
+  const off_t size = lseek(s->fd, 0, SEEK_END);
+  if (size < 0 || (size_t) size % s->chunk_size)
+  {
+    fprintf(stderr, "%s: not a world file for height %d.\n", path, height);
+    exit(EX_DATAERR);
+  }
+
+  s->chunks = (long) ((size_t) size / s->chunk_size);
+  for (long k = 0; k < s->chunks; ++k)
+  {
+    uint64_t id;
+    if (pread(s->fd, &id, sizeof id, (off_t) ((size_t) k * s->chunk_size)) != (ssize_t) sizeof id)
+    {
+      perror(path);
+      exit(EX_IOERR);
+    }
+    *_offset(s, (long) id) = k;
+  }
+  return s;
+}
+
+void world_store_close(world_store* const s)
+{
+  if (!s)
+    return;
+
+  for (size_t i = 0; i < WORLD_MAPPED_CHUNKS; ++i)
+    if (s->mapped[i].data)
+      munmap(s->mapped[i].data, s->chunk_size);
+  free(s->offsets);
+  fclose(s->file);
+  free(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+/* Copy the column saved at x into c, if any. */
+bool world_store_load(world_store* const s, const long x, column* const c)
+{
+  const long id = _chunk_id(x);
+  uint64_t* const chunk = _map(s, id, false);
+  const size_t i = (size_t) (x - id * WORLD_CHUNK_COLUMNS);
+  if (!chunk || !(chunk[1] >> i & 1))
+    return false;
+
+  const uint64_t* const words = chunk + 2 + i * s->words;
+  for (size_t w = 0; w < s->words; ++w)
+    c->words[w * c->stride] = words[w];
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void world_store_save(world_store* const s, const long x, const column* const c)
+{
+  const long id = _chunk_id(x);
+  uint64_t* const chunk = _map(s, id, true);
+  const size_t i = (size_t) (x - id * WORLD_CHUNK_COLUMNS);
+
+  uint64_t* const words = chunk + 2 + i * s->words;
+  for (size_t w = 0; w < s->words; ++w)
+    words[w] = c->words[w * c->stride];
+  chunk[1] |= UINT64_C(1) << i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// local functions definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/* The store of an open file, with no chunk yet. */
+world_store* _new(FILE* const file, const int height)
+{
+  world_store* const s = malloc(sizeof *s);
+  if (!s)
+  {
+    perror("malloc");
+    exit(EX_OSERR);
+  }
+
+  s->file = file;
+  s->fd = fileno(file);
+
+  const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  s->words = COLUMN_PLANES * column_words(height);
+  s->chunk_size = sizeof (uint64_t) * (2 + WORLD_CHUNK_COLUMNS * s->words);
+  s->chunk_size = (s->chunk_size + page - 1) / page * page;
+  s->chunks = 0;
+  s->first = 0;
+  s->offsets = NULL;
+  s->count = 0;
+  for (size_t i = 0; i < WORLD_MAPPED_CHUNKS; ++i)
+    s->mapped[i] = (world_chunk) { .id = 0, .data = NULL, };
+  s->victim = 0;
+
+  return s;
+}
+
+/* Rounds towards minus infinity, x may be negative. */
+long _chunk_id(const long x)
+{
+  return (x >= 0 ? x : x - (WORLD_CHUNK_COLUMNS - 1)) / WORLD_CHUNK_COLUMNS;
+}
+
+/* Index entry of a chunk, growing the range to include it. */
+long* _offset(world_store* const s, const long id)
+{
+  if (!s->count)
+    s->first = id;
+
+  const long last = s->first + (long) s->count - 1;
+  if (s->count && id >= s->first && id <= last)
+    return s->offsets + (id - s->first);
+
+  const long first = id < s->first ? id : s->first;
+  const size_t count = (size_t) ((id > last ? id : last) - first + 1);
+  long* const offsets = realloc(s->offsets, sizeof *offsets * count);
+  if (!offsets)
+  {
+    perror("realloc");
+    exit(EX_OSERR);
+  }
+  const size_t shift = (size_t) (s->first - first);
+  memmove(offsets + shift, offsets, sizeof *offsets * s->count);
+  for (size_t i = 0; i < count; ++i)
+    if (i < shift || i >= shift + s->count)
+      offsets[i] = -1;
+
+  s->offsets = offsets;
+  s->first = first;
+  s->count = count;
+  return s->offsets + (id - s->first);
+}
+
+/* Map a chunk, allocating it in the file first if create is set. */
+uint64_t* _map(world_store* const s, const long id, const bool create)
+{
+  for (size_t i = 0; i < WORLD_MAPPED_CHUNKS; ++i)
+    if (s->mapped[i].data && s->mapped[i].id == id)
+      return s->mapped[i].data;
+
+  long* const offset = _offset(s, id);
+  const bool created = *offset < 0;
+  if (created)
+  {
+    if (!create)
+      return NULL;
+    /* The new chunk reads as zeros: no column saved yet. */
+    *offset = s->chunks++;
+    if (ftruncate(s->fd, (off_t) ((size_t) s->chunks * s->chunk_size)))
+    {
+      perror("ftruncate");
+      exit(EX_IOERR);
+    }
+  }
+
+  world_chunk* const victim = s->mapped + s->victim;
+  s->victim = (s->victim + 1) % WORLD_MAPPED_CHUNKS;
+  if (victim->data)
+    munmap(victim->data, s->chunk_size);
+  victim->data = mmap(
+      NULL, s->chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd,
+      (off_t) ((size_t) *offset * s->chunk_size));
+  if (victim->data == MAP_FAILED)
+  {
+    perror("mmap");
+    exit(EX_IOERR);
+  }
+  victim->id = id;
+  if (created)
+    victim->data[0] = (uint64_t) id;
+  return victim->data;
+}
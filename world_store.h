@@ -0,0 +1,54 @@
+#ifndef _WORLD_STORE_H_
+#define _WORLD_STORE_H_
+
+/*
+ *        DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                    Version 2, December 2004
+ *
+ * Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+ *
+ * Everyone is permitted to copy and distribute verbatim or modified
+ * copies of this license document, and changing it is allowed as long
+ * as the name is changed.
+ *
+ *            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *  0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#include <stdbool.h>
+#include "column.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// types
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * On-disk history of the columns that left the screen, indexed by their world
+ * x coordinate. The file is made of fixed-size chunks of WORLD_CHUNK_COLUMNS
+ * columns that are memory-mapped on demand, only a few at a time.
+ */
+typedef struct world_store world_store;
+
+////////////////////////////////////////////////////////////////////////////////
+// init./destroy etc.
+////////////////////////////////////////////////////////////////////////////////
+
+world_store* world_store_open(const char* path, int height);
+world_store* world_store_reopen(const char* path, int height);
+void world_store_close(world_store* s);
+
+////////////////////////////////////////////////////////////////////////////////
+// getters
+////////////////////////////////////////////////////////////////////////////////
+
+bool world_store_load(world_store* s, long x, column* c);
+
+////////////////////////////////////////////////////////////////////////////////
+// setters / modifiers
+////////////////////////////////////////////////////////////////////////////////
+
+void world_store_save(world_store* s, long x, const column* c);
+
+#endif